@@ -0,0 +1,438 @@
+// Envío de logs a logs_manager sin bloquear el ciclo principal.
+//
+// El ciclo solo serializa la muestra y la deja en una cola acotada; una tarea
+// aparte arma lotes de hasta batch_size muestras (o las que haya al pasar
+// batch_interval), los comprime con gzip como NDJSON y los manda a /logs/bulk.
+// Si logs_manager no responde, el lote se guarda en un spool en disco y se
+// reintenta con espera exponencial; al volver el servicio se envía primero lo
+// del spool, así los logs llegan en orden. Si la cola se llena o el spool pasa
+// de su tamaño máximo se descartan muestras y se cuentan en las métricas.
+use std::collections::VecDeque;
+use std::fmt;
+use std::fs;
+use std::io::Write;
+use std::path::PathBuf;
+use std::str::FromStr;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::Duration;
+
+use flate2::write::GzEncoder;
+use flate2::Compression;
+use reqwest::header::{CONTENT_ENCODING, CONTENT_TYPE};
+use serde::Serialize;
+use tokio::sync::mpsc;
+use tokio::task::JoinHandle;
+use tokio::time::{sleep_until, Instant};
+
+const BACKOFF_MIN: Duration = Duration::from_secs(1);
+const BACKOFF_MAX: Duration = Duration::from_secs(60);
+
+pub struct ShipperConfig {
+    pub endpoint: String,
+    pub queue_capacity: usize,
+    pub batch_size: usize,
+    pub batch_interval: Duration,
+    pub request_timeout: Duration,
+    pub spool_dir: PathBuf,
+    pub spool_max_bytes: u64,
+}
+
+fn env_or<T: FromStr>(name: &str, default: T) -> T {
+    std::env::var(name).ok().and_then(|v| v.parse().ok()).unwrap_or(default)
+}
+
+impl ShipperConfig {
+    pub fn from_env() -> Self {
+        ShipperConfig {
+            endpoint: env_or("LOGS_BULK_ENDPOINT", "http://localhost:5000/logs/bulk".to_string()),
+            queue_capacity: env_or("LOGS_QUEUE_CAPACITY", 256usize).max(1),
+            batch_size: env_or("LOGS_BATCH_SIZE", 32usize).max(1),
+            batch_interval: Duration::from_millis(env_or("LOGS_BATCH_INTERVAL_MS", 30_000u64)),
+            request_timeout: Duration::from_millis(env_or("LOGS_REQUEST_TIMEOUT_MS", 5_000u64)),
+            spool_dir: PathBuf::from(env_or("LOGS_SPOOL_DIR", "/var/tmp/container_manager/spool".to_string())),
+            spool_max_bytes: env_or("LOGS_SPOOL_MAX_MB", 64u64) * 1024 * 1024,
+        }
+    }
+}
+
+// Contadores de muestras; queued y spooled son el estado actual, los demás acumulan
+#[derive(Default)]
+pub struct ShipperMetrics {
+    pub queued: AtomicU64,
+    pub sent: AtomicU64,
+    pub spooled: AtomicU64,
+    pub dropped: AtomicU64,
+    pub failed_requests: AtomicU64,
+}
+
+impl fmt::Display for ShipperMetrics {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        write!(
+            f,
+            "Logs: en cola {}, enviados {}, en disco {}, descartados {}, envíos fallidos {}",
+            self.queued.load(Ordering::Relaxed),
+            self.sent.load(Ordering::Relaxed),
+            self.spooled.load(Ordering::Relaxed),
+            self.dropped.load(Ordering::Relaxed),
+            self.failed_requests.load(Ordering::Relaxed),
+        )
+    }
+}
+
+pub struct LogShipper {
+    tx: mpsc::Sender<String>,
+    metrics: Arc<ShipperMetrics>,
+    task: JoinHandle<()>,
+}
+
+impl LogShipper {
+    pub fn start(config: ShipperConfig) -> Self {
+        let (tx, rx) = mpsc::channel(config.queue_capacity);
+        let metrics = Arc::new(ShipperMetrics::default());
+        let worker = Worker::new(config, rx, metrics.clone());
+        LogShipper { tx, metrics, task: tokio::spawn(worker.run()) }
+    }
+
+    pub fn metrics(&self) -> &ShipperMetrics {
+        &self.metrics
+    }
+
+    // No espera nunca: si la cola está llena la muestra se descarta
+    pub fn enqueue<T: Serialize>(&self, entry: &T) -> bool {
+        let line = match serde_json::to_string(entry) {
+            Ok(line) => line,
+            Err(e) => {
+                println!("[ERROR] No se pudo serializar el log: {}", e);
+                self.metrics.dropped.fetch_add(1, Ordering::Relaxed);
+                return false;
+            }
+        };
+
+        self.metrics.queued.fetch_add(1, Ordering::Relaxed);
+        if self.tx.try_send(line).is_err() {
+            self.metrics.queued.fetch_sub(1, Ordering::Relaxed);
+            self.metrics.dropped.fetch_add(1, Ordering::Relaxed);
+            return false;
+        }
+        true
+    }
+
+    // Cierra la cola y espera a que el último lote se envíe o quede en el spool
+    pub async fn shutdown(self, wait: Duration) {
+        let LogShipper { tx, metrics, task } = self;
+        drop(tx);
+        if tokio::time::timeout(wait, task).await.is_err() {
+            println!("[WARN] El envío de logs no terminó a tiempo; {}", metrics);
+        }
+    }
+}
+
+enum SendResult {
+    Sent,
+    // logs_manager respondió 4xx: reintentar el mismo lote no sirve
+    Rejected,
+    Failed,
+}
+
+struct Backoff {
+    delay: Duration,
+    retry_at: Instant,
+}
+
+impl Backoff {
+    fn new() -> Self {
+        Backoff { delay: BACKOFF_MIN, retry_at: Instant::now() }
+    }
+
+    fn ready(&self) -> bool {
+        Instant::now() >= self.retry_at
+    }
+
+    fn failed(&mut self) {
+        self.retry_at = Instant::now() + self.delay;
+        self.delay = (self.delay * 2).min(BACKOFF_MAX);
+    }
+
+    fn reset(&mut self) {
+        self.delay = BACKOFF_MIN;
+        self.retry_at = Instant::now();
+    }
+}
+
+struct SpoolFile {
+    path: PathBuf,
+    samples: u64,
+    bytes: u64,
+}
+
+// Lotes pendientes en disco, uno por archivo: <secuencia>-<muestras>.ndjson.gz
+struct Spool {
+    dir: PathBuf,
+    max_bytes: u64,
+    files: VecDeque<SpoolFile>,
+    bytes: u64,
+    next_seq: u64,
+    metrics: Arc<ShipperMetrics>,
+}
+
+impl Spool {
+    fn open(dir: PathBuf, max_bytes: u64, metrics: Arc<ShipperMetrics>) -> Self {
+        let mut spool = Spool { dir, max_bytes, files: VecDeque::new(), bytes: 0, next_seq: 1, metrics };
+        if let Err(e) = fs::create_dir_all(&spool.dir) {
+            println!("[WARN] No se pudo crear el spool {}: {}", spool.dir.display(), e);
+            return spool;
+        }
+
+        let mut found: Vec<(u64, SpoolFile)> = Vec::new();
+        for entry in fs::read_dir(&spool.dir).into_iter().flatten().flatten() {
+            let path = entry.path();
+            let name = entry.file_name().to_string_lossy().into_owned();
+            if name.ends_with(".tmp") {
+                // Escritura interrumpida: el lote nunca quedó completo
+                let _ = fs::remove_file(&path);
+                continue;
+            }
+            let parsed = name.strip_suffix(".ndjson.gz").and_then(|stem| {
+                let (seq, samples) = stem.split_once('-')?;
+                Some((seq.parse::<u64>().ok()?, samples.parse::<u64>().ok()?))
+            });
+            if let (Some((seq, samples)), Ok(meta)) = (parsed, entry.metadata()) {
+                found.push((seq, SpoolFile { path, samples, bytes: meta.len() }));
+            }
+        }
+
+        found.sort_by_key(|(seq, _)| *seq);
+        for (seq, file) in found {
+            spool.next_seq = seq + 1;
+            spool.bytes += file.bytes;
+            spool.metrics.spooled.fetch_add(file.samples, Ordering::Relaxed);
+            spool.files.push_back(file);
+        }
+        if !spool.files.is_empty() {
+            println!("[INFO] {} lotes de logs pendientes en {}", spool.files.len(), spool.dir.display());
+        }
+        spool
+    }
+
+    fn is_empty(&self) -> bool {
+        self.files.is_empty()
+    }
+
+    fn push(&mut self, body: &[u8], samples: u64) {
+        let path = self.dir.join(format!("{:020}-{}.ndjson.gz", self.next_seq, samples));
+        let tmp = path.with_extension("tmp");
+        let written = fs::write(&tmp, body).and_then(|_| fs::rename(&tmp, &path));
+        if let Err(e) = written {
+            println!("[ERROR] No se pudo guardar el lote en {}: {}", path.display(), e);
+            let _ = fs::remove_file(&tmp);
+            self.metrics.dropped.fetch_add(samples, Ordering::Relaxed);
+            return;
+        }
+
+        self.next_seq += 1;
+        self.bytes += body.len() as u64;
+        self.metrics.spooled.fetch_add(samples, Ordering::Relaxed);
+        self.files.push_back(SpoolFile { path, samples, bytes: body.len() as u64 });
+
+        // Se descartan los lotes más viejos; el último siempre se conserva
+        while self.bytes > self.max_bytes && self.files.len() > 1 {
+            let samples = self.pop();
+            self.metrics.dropped.fetch_add(samples, Ordering::Relaxed);
+        }
+    }
+
+    fn front(&self) -> Option<&SpoolFile> {
+        self.files.front()
+    }
+
+    fn pop(&mut self) -> u64 {
+        match self.files.pop_front() {
+            Some(file) => {
+                let _ = fs::remove_file(&file.path);
+                self.bytes -= file.bytes;
+                self.metrics.spooled.fetch_sub(file.samples, Ordering::Relaxed);
+                file.samples
+            }
+            None => 0,
+        }
+    }
+}
+
+struct Worker {
+    config: ShipperConfig,
+    rx: mpsc::Receiver<String>,
+    metrics: Arc<ShipperMetrics>,
+    client: reqwest::Client,
+    spool: Spool,
+    backoff: Backoff,
+    batch: Vec<String>,
+    // Momento en que se envía el lote abierto aunque no esté lleno
+    flush_at: Option<Instant>,
+}
+
+enum Wake {
+    Log(Option<String>),
+    Flush,
+    Retry,
+}
+
+impl Worker {
+    fn new(config: ShipperConfig, rx: mpsc::Receiver<String>, metrics: Arc<ShipperMetrics>) -> Self {
+        let client = reqwest::Client::builder()
+            .timeout(config.request_timeout)
+            .build()
+            .unwrap_or_else(|_| reqwest::Client::new());
+        let spool = Spool::open(config.spool_dir.clone(), config.spool_max_bytes, metrics.clone());
+        Worker {
+            batch: Vec::with_capacity(config.batch_size),
+            config,
+            rx,
+            metrics,
+            client,
+            spool,
+            backoff: Backoff::new(),
+            flush_at: None,
+        }
+    }
+
+    async fn run(mut self) {
+        loop {
+            let flush_at = self.flush_at.unwrap_or_else(Instant::now);
+            let retry_at = self.backoff.retry_at;
+            let wake = tokio::select! {
+                line = self.rx.recv() => Wake::Log(line),
+                _ = sleep_until(flush_at), if self.flush_at.is_some() => Wake::Flush,
+                _ = sleep_until(retry_at), if !self.spool.is_empty() => Wake::Retry,
+            };
+
+            match wake {
+                Wake::Log(Some(line)) => {
+                    self.metrics.queued.fetch_sub(1, Ordering::Relaxed);
+                    if self.batch.is_empty() {
+                        self.flush_at = Some(Instant::now() + self.config.batch_interval);
+                    }
+                    self.batch.push(line);
+                    if self.batch.len() >= self.config.batch_size {
+                        self.flush().await;
+                    }
+                }
+                Wake::Log(None) => {
+                    // Se cerró la cola: lo que no se pueda enviar queda en el spool para la próxima ejecución
+                    self.flush().await;
+                    self.replay().await;
+                    return;
+                }
+                Wake::Flush => self.flush().await,
+                Wake::Retry => self.replay().await,
+            }
+        }
+    }
+
+    async fn flush(&mut self) {
+        self.flush_at = None;
+        if self.batch.is_empty() {
+            return;
+        }
+        let batch = std::mem::replace(&mut self.batch, Vec::with_capacity(self.config.batch_size));
+        let samples = batch.len() as u64;
+
+        let body = match gzip_ndjson(&batch) {
+            Ok(body) => body,
+            Err(e) => {
+                println!("[ERROR] No se pudo comprimir el lote de logs: {}", e);
+                self.metrics.dropped.fetch_add(samples, Ordering::Relaxed);
+                return;
+            }
+        };
+
+        // Con lotes pendientes en disco el nuevo va detrás de ellos para no desordenar los logs
+        if self.spool.is_empty() && self.backoff.ready() {
+            match self.post(body.clone()).await {
+                SendResult::Sent => {
+                    self.metrics.sent.fetch_add(samples, Ordering::Relaxed);
+                    return;
+                }
+                SendResult::Rejected => {
+                    self.metrics.dropped.fetch_add(samples, Ordering::Relaxed);
+                    return;
+                }
+                SendResult::Failed => {}
+            }
+        }
+        self.spool.push(&body, samples);
+        self.replay().await;
+    }
+
+    // Envía los lotes del spool del más viejo al más nuevo hasta vaciarlo o fallar
+    async fn replay(&mut self) {
+        while self.backoff.ready() {
+            let (path, samples) = match self.spool.front() {
+                Some(file) => (file.path.clone(), file.samples),
+                None => return,
+            };
+            let body = match fs::read(&path) {
+                Ok(body) => body,
+                Err(e) => {
+                    println!("[ERROR] No se pudo leer {}: {}", path.display(), e);
+                    self.metrics.dropped.fetch_add(self.spool.pop(), Ordering::Relaxed);
+                    continue;
+                }
+            };
+
+            match self.post(body).await {
+                SendResult::Sent => {
+                    self.spool.pop();
+                    self.metrics.sent.fetch_add(samples, Ordering::Relaxed);
+                }
+                SendResult::Rejected => {
+                    self.metrics.dropped.fetch_add(self.spool.pop(), Ordering::Relaxed);
+                }
+                SendResult::Failed => return,
+            }
+        }
+    }
+
+    async fn post(&mut self, body: Vec<u8>) -> SendResult {
+        let response = self.client
+            .post(&self.config.endpoint)
+            .header(CONTENT_TYPE, "application/x-ndjson")
+            .header(CONTENT_ENCODING, "gzip")
+            .body(body)
+            .send()
+            .await;
+
+        match response {
+            Ok(resp) if resp.status().is_success() => {
+                self.backoff.reset();
+                SendResult::Sent
+            }
+            Ok(resp) if resp.status().is_client_error() => {
+                println!("[ERROR] logs_manager rechazó un lote de logs: {}", resp.status());
+                self.backoff.reset();
+                SendResult::Rejected
+            }
+            Ok(resp) => {
+                println!("[WARN] logs_manager respondió {}; el lote queda en el spool", resp.status());
+                self.metrics.failed_requests.fetch_add(1, Ordering::Relaxed);
+                self.backoff.failed();
+                SendResult::Failed
+            }
+            Err(e) => {
+                println!("[WARN] No se pudo enviar el lote de logs: {}", e);
+                self.metrics.failed_requests.fetch_add(1, Ordering::Relaxed);
+                self.backoff.failed();
+                SendResult::Failed
+            }
+        }
+    }
+}
+
+fn gzip_ndjson(lines: &[String]) -> std::io::Result<Vec<u8>> {
+    let mut encoder = GzEncoder::new(Vec::new(), Compression::default());
+    for line in lines {
+        encoder.write_all(line.as_bytes())?;
+        encoder.write_all(b"\n")?;
+    }
+    encoder.finish()
+}
@@ -1,8 +1,7 @@
-use std::{fs, thread, time, process::Command};
+use std::{fs, time, process::Command};
 use serde::{Deserialize, Serialize};
-use reqwest::blocking::Client;
+use reqwest::Client;
 use bollard::Docker;
-use bollard::container::{Config, CreateContainerOptions, StartContainerOptions, RemoveContainerOptions, ListContainersOptions};
 use signal_hook::consts::SIGINT;
 use signal_hook::flag;
 use std::sync::atomic::{AtomicBool, Ordering};
@@ -14,6 +13,11 @@ use prettytable::{Table, row};
 use std::thread::JoinHandle;
 use tokio;
 
+mod log_shipper;
+mod reconciler;
+use log_shipper::{LogShipper, ShipperConfig};
+use reconciler::{Reconciler, ReconcilerConfig};
+
 // Updated structure for kernel data
 #[derive(Debug, Deserialize, Serialize, Clone)]
 struct SysInfo {
@@ -63,22 +67,14 @@ fn create_log_entry(sysinfo: SysInfo) -> LogEntry {
 // Constants
 const SYSINFO_PATH: &str = "/proc/sysinfo_202202906";
 const LOGS_CONTAINER: &str = "logs_managerr";
-const LOGS_ENDPOINT: &str = "http://localhost:5000/logs";
+// Tiempo máximo para enviar (o guardar en el spool) los logs pendientes al terminar
+const SHUTDOWN_FLUSH_TIMEOUT: time::Duration = time::Duration::from_secs(10);
 
 fn read_sysinfo() -> Option<SysInfo> {
     let data = fs::read_to_string(SYSINFO_PATH).ok()?;
     serde_json::from_str(&data).ok()
 }
 
-fn send_log(client: &Client, log_data: &SysInfo) {
-    let log_entry = LogEntry {
-        timestamp: Utc::now().to_rfc3339(),
-        sysinfo: (*log_data).clone(),
-    };
-
-    let _ = client.post(LOGS_ENDPOINT).json(&log_entry).send();
-}
-
 fn classify_containers(containers: &[ContainerInfo]) -> HashMap<&str, Vec<&ContainerInfo>> {
     let mut containers_by_category: HashMap<&str, Vec<&ContainerInfo>> = HashMap::new();
 
@@ -106,147 +102,25 @@ fn classify_containers(containers: &[ContainerInfo]) -> HashMap<&str, Vec<&Conta
     containers_by_category
 }
 
-async fn manage_containers(docker: &Docker, containers: &[ContainerInfo]) {
-    let existing_containers = docker.list_containers(Some(ListContainersOptions::<String> {
-        all: true,
-        ..Default::default()
-    })).await.unwrap_or_else(|_| vec![]);
-
+// Las decisiones de eliminar y crear contenedores las toma el reconciliador
+// (reconciler.rs) con el estado de Docker; aquí solo se muestran las métricas
+// del módulo kernel agrupadas por categoría
+fn print_containers_by_category(containers: &[ContainerInfo]) {
     let latest_containers = classify_containers(containers);
     let required_categories = ["cpu", "ram", "io", "disk"];
-    let mut removal_tasks: Vec<tokio::task::JoinHandle<(ContainerInfo, String)>> = Vec::new();
-    let mut removed_containers: Vec<(ContainerInfo, String)> = Vec::new();
 
-    // Step 1: Display containers
     println!("\n[INFO] Contenedores por categoría:");
     for category in required_categories.iter().chain(std::iter::once(&"unknown")) {
         if let Some(containers_in_category) = latest_containers.get(category) {
-            let mut table = Table::new();
-            table.add_row(row!["PID", "Nombre", "Container ID", "CPU %", "RAM %", "RAM MB", "Disk MB", "IO Read Ops", "IO Write Ops"]);
-            for container in containers_in_category {
-                table.add_row(row![
-                    container.PID,
-                    container.Name,
-                    container.ContainerID,
-                    format!("{:.2}", container.CPUUsage_percent),
-                    format!("{:.2}", container.MemoryUsage_percent),
-                    container.MemoryUsage_MB,
-                    container.DiskUse_MB,
-                    container.IOReadOps,
-                    container.IOWriteOps,
-                ]);
-            }
             println!("{}:", category.to_uppercase());
-            table.printstd();
+            print_containers(containers_in_category.iter().copied());
             println!();
         }
     }
-
-    // Step 2: Manage containers using Tokio tasks
-    for category in required_categories {
-        if let Some(containers_in_category) = latest_containers.get(category) {
-            let mut sorted_containers = containers_in_category.clone();
-            sorted_containers.sort_by(|a, b| b.PID.cmp(&a.PID));
-
-            if sorted_containers.len() > 1 {
-                for old_container in sorted_containers.iter().skip(1) {
-                    let container_id = old_container.ContainerID.clone();
-                    let container_name = old_container.Name.clone();
-                    let container_pid = old_container.PID;
-                    let category_str = category.to_string();
-                    let docker_clone = docker.clone();
-
-                    println!("\n[INFO] Iniciando eliminación en tarea para contenedor: {} (ID: {})", 
-                            container_name, container_id);
-
-                    let task = tokio::spawn(async move {
-                        match docker_clone.remove_container(
-                            &container_id,
-                            Some(RemoveContainerOptions {
-                                force: true,
-                                ..Default::default()
-                            })
-                        ).await {
-                            Ok(_) => {
-                                println!("\n[DEBUG] Contenedor {} eliminado con éxito en tarea", container_id);
-                                let container_info = ContainerInfo {
-                                    PID: container_pid,
-                                    Name: container_name.clone(),
-                                    ContainerID: container_id.clone(),
-                                    Cmdline: String::new(),
-                                    MemoryUsage_percent: 0.0,
-                                    MemoryUsage_MB: 0.0,
-                                    CPUUsage_percent: 0.0,
-                                    DiskUse_MB: 0.0,
-                                    Write_KBytes: 0,
-                                    Read_KBytes: 0,
-                                    IOReadOps: 0,
-                                    IOWriteOps: 0,
-                                };
-                                (container_info, category_str)
-                            }
-                            Err(e) => {
-                                println!("\n[ERROR] Error al eliminar contenedor {} en tarea: {:?}", 
-                                        container_id, e);
-                                let container_info = ContainerInfo {
-                                    PID: container_pid,
-                                    Name: container_name,
-                                    ContainerID: container_id,
-                                    Cmdline: String::new(),
-                                    MemoryUsage_percent: 0.0,
-                                    MemoryUsage_MB: 0.0,
-                                    CPUUsage_percent: 0.0,
-                                    DiskUse_MB: 0.0,
-                                    Write_KBytes: 0,
-                                    Read_KBytes: 0,
-                                    IOReadOps: 0,
-                                    IOWriteOps: 0,
-                                };
-                                (container_info, "error".to_string())
-                            }
-                        }
-                    });
-
-                    removal_tasks.push(task);
-                }
-            }
-        }
-    }
-
-    // Step 3: Collect results from tasks
-    for task in removal_tasks {
-        match task.await {  // task.await returns Result<(ContainerInfo, String), JoinError>
-            Ok((container, category)) => {  // Directly match the inner tuple
-                if category != "error" {
-                    removed_containers.push((container, category));
-                }
-            }
-            Err(e) => {
-                println!("\n[ERROR] Error al esperar la tarea de eliminación: {:?}", e);
-            }
-        }
-    }
-
-    // Step 4: Display table
-    if !removed_containers.is_empty() {
-        println!("\n[INFO] Contenedores eliminados:");
-        let mut table = Table::new();
-        table.add_row(row!["Container ID", "Categoría", "PID"]);
-        for (container, category) in &removed_containers {
-            table.add_row(row![
-                &container.ContainerID,
-                category,
-                container.PID,
-            ]);
-        }
-        table.printstd();
-    } else {
-        println!("\n[INFO] No se eliminaron contenedores.");
-    }
 }
 
 // Updated print_containers to reflect new fields
-fn print_containers(containers: &[ContainerInfo]) {
+fn print_containers<'a>(containers: impl IntoIterator<Item = &'a ContainerInfo>) {
     let mut table = Table::new();
     table.add_row(row!["PID", "Nombre", "Container ID", "CPU %", "RAM %", "RAM MB", "Disk MB", "IO Read Ops", "IO Write Ops"]);
 
@@ -308,11 +182,17 @@ async fn main() {
 
     let client = Client::new();
     let docker = Docker::connect_with_local_defaults().unwrap();
+    let shipper = LogShipper::start(ShipperConfig::from_env());
+    let reconciler = Reconciler::start(docker, ReconcilerConfig::from_env());
 
     println!("[INFO] Iniciando servicio de gestión de contenedores...");
 
     while !stop_flag.load(Ordering::Relaxed) {
         if let Some(sysinfo) = read_sysinfo() {
+            // La marca de tiempo es la de la lectura, no la del envío
+            let log_entry = create_log_entry(sysinfo);
+            let sysinfo = &log_entry.sysinfo;
+
             println!("\n[INFO] Información del sistema:");
             println!("Memoria Total: {} MB", sysinfo.Memory.Total_Memory_MB);
             println!("Memoria Libre: {} MB", sysinfo.Memory.Free_Memory_MB);
@@ -321,30 +201,34 @@ async fn main() {
             println!("\n[INFO] Contenedores:");
             print_containers(&sysinfo.Docker_Containers);
 
-            send_log(&client, &sysinfo);
-            manage_containers(&docker, &sysinfo.Docker_Containers).await;
+            shipper.enqueue(&log_entry);
+            print_containers_by_category(&sysinfo.Docker_Containers);
         }
 
-        thread::sleep(time::Duration::from_secs(10));
+        reconciler.reconcile();
+        reconciler.print_summary();
+        println!("\n[INFO] {}", shipper.metrics());
+        tokio::time::sleep(time::Duration::from_secs(10)).await;
     }
 
     println!("\n[INFO] Finalizando servicio...");
     remove_cronjob();
 
     if let Some(sysinfo) = read_sysinfo() {
-        send_log(&client, &sysinfo);
+        shipper.enqueue(&create_log_entry(sysinfo));
     }
+    shipper.shutdown(SHUTDOWN_FLUSH_TIMEOUT).await;
 
-    generate_graphs(&client);
-    show_live_graphs(&client);
+    generate_graphs(&client).await;
+    show_live_graphs(&client).await;
 
     println!("[INFO] Gráficas generadas correctamente. Servicio terminado.");
 }
 
-fn generate_graphs(client: &Client) {
-    let _ = client.get("http://localhost:5000/generate_graphs").send();
+async fn generate_graphs(client: &Client) {
+    let _ = client.get("http://localhost:5000/generate_graphs").send().await;
 }
 
-fn show_live_graphs(client: &Client) {
-    let _ = client.get("http://localhost:5000/show_graphs").send();
+async fn show_live_graphs(client: &Client) {
+    let _ = client.get("http://localhost:5000/show_graphs").send().await;
 }
\ No newline at end of file
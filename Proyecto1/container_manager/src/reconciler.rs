@@ -0,0 +1,458 @@
+// Reconciliador de contenedores de estrés.
+//
+// Guarda en memoria el estado observado de los contenedores (lo que hay en
+// Docker) y lo compara con el deseado: un solo contenedor corriendo por
+// categoría, el más reciente. El estado observado se llena con una lista al
+// arrancar y después se mantiene con el stream de eventos de Docker; solo se
+// vuelve a listar al reconectar el stream o cada RECONCILE_RESYNC_SECS por si
+// se perdió algún evento. Cada ciclo, reconcile() calcula las diferencias en
+// memoria y encola eliminaciones y creaciones en un pool fijo de workers, sin
+// esperar a Docker, así la duración del ciclo no depende de cuántos
+// contenedores haya. Una operación que falla se reintenta con espera
+// exponencial por contenedor (o por categoría, en las creaciones).
+use std::collections::{HashMap, HashSet};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+use bollard::container::{Config, CreateContainerOptions, ListContainersOptions, RemoveContainerOptions, StartContainerOptions};
+use bollard::errors::Error as DockerError;
+use bollard::models::EventMessage;
+use bollard::system::EventsOptions;
+use bollard::Docker;
+use futures::StreamExt;
+use prettytable::{Table, row};
+use tokio::sync::mpsc;
+use tokio::time::Instant;
+
+const BACKOFF_MIN: Duration = Duration::from_secs(1);
+const BACKOFF_MAX: Duration = Duration::from_secs(300);
+// Tiempo máximo de una operación contra Docker; un worker nunca se queda trabado
+const DOCKER_OP_TIMEOUT: Duration = Duration::from_secs(30);
+
+// Un contenedor que sigue sin arrancar después de esto se trata como terminado
+const CREATED_GRACE_NS: i64 = 60_000_000_000;
+
+// Eventos que se acumulan mientras corre una lista
+const EVENTS_BUFFER: usize = 1024;
+// Segunda lista después de abrir el stream de eventos
+const EVENTS_SETTLE: Duration = Duration::from_secs(2);
+
+const STRESS_IMAGE: &str = "containerstack/alpine-stress";
+
+// Categorías administradas. Los contenedores se reconocen por el nombre que
+// les pone script.sh: stress_<tipo>_<id>
+struct CategorySpec {
+    category: &'static str,
+    name_type: &'static str,
+    stress_args: &'static str,
+}
+
+const CATEGORIES: [CategorySpec; 4] = [
+    CategorySpec { category: "cpu", name_type: "cpu", stress_args: "--cpu 1" },
+    CategorySpec { category: "ram", name_type: "vm", stress_args: "--vm 2 --vm-bytes 256M" },
+    CategorySpec { category: "io", name_type: "io", stress_args: "--io 1" },
+    CategorySpec { category: "disk", name_type: "hdd", stress_args: "--hdd 1" },
+];
+
+fn category_of(name: &str) -> Option<&'static str> {
+    let name = name.trim_start_matches('/');
+    let name_type = name.strip_prefix("stress_")?.split('_').next()?;
+    CATEGORIES.iter().find(|spec| spec.name_type == name_type).map(|spec| spec.category)
+}
+
+pub struct ReconcilerConfig {
+    pub workers: usize,
+    pub queue_capacity: usize,
+    pub create_missing: bool,
+    pub resync_interval: Duration,
+}
+
+fn env_or<T: std::str::FromStr>(name: &str, default: T) -> T {
+    std::env::var(name).ok().and_then(|v| v.parse().ok()).unwrap_or(default)
+}
+
+impl ReconcilerConfig {
+    pub fn from_env() -> Self {
+        ReconcilerConfig {
+            workers: env_or("RECONCILE_WORKERS", 4usize).max(1),
+            queue_capacity: env_or("RECONCILE_QUEUE_CAPACITY", 64usize).max(1),
+            create_missing: env_or("RECONCILE_CREATE_MISSING", true),
+            resync_interval: Duration::from_secs(env_or("RECONCILE_RESYNC_SECS", 300u64).max(1)),
+        }
+    }
+}
+
+#[derive(Clone, Copy, PartialEq)]
+enum ContainerState {
+    // Creado pero sin arrancar: docker run lo arranca enseguida, no se toca
+    Created,
+    Running,
+    Exited,
+}
+
+struct Observed {
+    name: String,
+    category: &'static str,
+    created_ns: i64,
+    state: ContainerState,
+}
+
+impl Observed {
+    fn effective_state(&self, now_ns: i64) -> ContainerState {
+        if self.state == ContainerState::Created && now_ns - self.created_ns > CREATED_GRACE_NS {
+            return ContainerState::Exited;
+        }
+        self.state
+    }
+}
+
+fn now_ns() -> i64 {
+    SystemTime::now().duration_since(UNIX_EPOCH).map_or(0, |d| d.as_nanos() as i64)
+}
+
+enum Job {
+    Remove { id: String, name: String, category: &'static str },
+    Create { category: &'static str },
+}
+
+impl Job {
+    fn key(&self) -> String {
+        match self {
+            Job::Remove { id, .. } => id.clone(),
+            Job::Create { category } => format!("create:{}", category),
+        }
+    }
+}
+
+struct Retry {
+    delay: Duration,
+    retry_at: Instant,
+}
+
+// Operación terminada, para la tabla que se imprime en cada ciclo
+struct Finished {
+    action: &'static str,
+    id: String,
+    name: String,
+    category: &'static str,
+}
+
+#[derive(Default)]
+struct State {
+    containers: HashMap<String, Observed>,
+    // Falso hasta la primera lista y mientras el stream de eventos está caído:
+    // no se actúa sobre un estado que puede estar viejo
+    synced: bool,
+    in_flight: HashSet<String>,
+    retries: HashMap<String, Retry>,
+    finished: Vec<Finished>,
+}
+
+impl State {
+    fn resync(&mut self, containers: HashMap<String, Observed>) {
+        self.containers = containers;
+        self.synced = true;
+    }
+
+    fn apply(&mut self, event: &EventMessage) {
+        let (Some(action), Some(actor)) = (event.action.as_deref(), event.actor.as_ref()) else { return };
+        let Some(id) = actor.id.as_ref() else { return };
+        let name = actor.attributes.as_ref().and_then(|attrs| attrs.get("name")).cloned().unwrap_or_default();
+        let Some(category) = category_of(&name) else { return };
+        let time_ns = event.time_nano.unwrap_or(0);
+
+        let state = match action {
+            "create" => ContainerState::Created,
+            "start" => ContainerState::Running,
+            "die" => ContainerState::Exited,
+            "destroy" => {
+                self.containers.remove(id);
+                self.retries.remove(id);
+                return;
+            }
+            _ => return,
+        };
+        self.containers
+            .entry(id.clone())
+            .and_modify(|c| c.state = state)
+            .or_insert(Observed { name, category, created_ns: time_ns, state });
+    }
+
+    fn backing_off(&self, key: &str, now: Instant) -> bool {
+        self.retries.get(key).map_or(false, |r| r.retry_at > now)
+    }
+
+    // Diferencias entre el estado observado y el deseado
+    fn plan(&self, create_missing: bool) -> Vec<Job> {
+        let now = Instant::now();
+        let now_ns = now_ns();
+        let mut by_category: HashMap<&'static str, Vec<(&String, &Observed)>> = HashMap::new();
+        for (id, c) in &self.containers {
+            by_category.entry(c.category).or_default().push((id, c));
+        }
+
+        let mut jobs = Vec::new();
+        for spec in &CATEGORIES {
+            let mut containers = by_category.remove(spec.category).unwrap_or_default();
+            // El más reciente primero; el id desempata para que la decisión sea estable
+            containers.sort_by(|a, b| (b.1.created_ns, b.0).cmp(&(a.1.created_ns, a.0)));
+
+            let keep = containers.iter().find(|(id, c)| {
+                c.effective_state(now_ns) == ContainerState::Running && !self.in_flight.contains(*id)
+            });
+            let starting = containers.iter().any(|(_, c)| c.effective_state(now_ns) == ContainerState::Created);
+            for (id, c) in &containers {
+                if keep.map_or(false, |(keep_id, _)| keep_id == id) || c.effective_state(now_ns) == ContainerState::Created {
+                    continue;
+                }
+                if self.in_flight.contains(*id) || self.backing_off(id, now) {
+                    continue;
+                }
+                jobs.push(Job::Remove { id: (*id).clone(), name: c.name.clone(), category: spec.category });
+            }
+
+            let create = Job::Create { category: spec.category };
+            let key = create.key();
+            if create_missing && keep.is_none() && !starting && !self.in_flight.contains(&key) && !self.backing_off(&key, now) {
+                jobs.push(create);
+            }
+        }
+        jobs
+    }
+
+    fn finish(&mut self, key: String, result: Result<Finished, String>) {
+        self.in_flight.remove(&key);
+        match result {
+            Ok(done) => {
+                self.retries.remove(&key);
+                // No se espera a los eventos de Docker para reflejar la operación,
+                // así el siguiente ciclo no la vuelve a planear
+                if done.action == "eliminado" {
+                    self.containers.remove(&key);
+                } else {
+                    self.containers.entry(done.id.clone()).or_insert(Observed {
+                        name: done.name.clone(),
+                        category: done.category,
+                        created_ns: now_ns(),
+                        state: ContainerState::Running,
+                    });
+                }
+                self.finished.push(done);
+            }
+            Err(e) => {
+                let now = Instant::now();
+                let retry = self.retries.entry(key.clone()).or_insert(Retry { delay: BACKOFF_MIN, retry_at: now });
+                retry.retry_at = now + retry.delay;
+                println!("\n[ERROR] {} (reintento en {}s)", e, retry.delay.as_secs());
+                retry.delay = (retry.delay * 2).min(BACKOFF_MAX);
+            }
+        }
+    }
+}
+
+pub struct Reconciler {
+    state: Arc<Mutex<State>>,
+    jobs: mpsc::Sender<Job>,
+    create_missing: bool,
+}
+
+impl Reconciler {
+    pub fn start(docker: Docker, config: ReconcilerConfig) -> Self {
+        let state = Arc::new(Mutex::new(State::default()));
+        let (tx, rx) = mpsc::channel(config.queue_capacity);
+        let rx = Arc::new(tokio::sync::Mutex::new(rx));
+
+        for _ in 0..config.workers {
+            tokio::spawn(worker(docker.clone(), rx.clone(), state.clone()));
+        }
+        tokio::spawn(watch_events(docker, state.clone(), config.resync_interval));
+
+        Reconciler { state, jobs: tx, create_missing: config.create_missing }
+    }
+
+    // Solo trabajo en memoria: las operaciones quedan en la cola del pool
+    pub fn reconcile(&self) {
+        let mut state = self.state.lock().unwrap();
+        if !state.synced {
+            println!("\n[WARN] Estado de Docker sin sincronizar; no se reconcilia en este ciclo.");
+            return;
+        }
+
+        for job in state.plan(self.create_missing) {
+            let key = job.key();
+            match self.jobs.try_send(job) {
+                Ok(()) => {
+                    state.in_flight.insert(key);
+                }
+                // Cola llena: lo que no entró se vuelve a planear en el siguiente ciclo
+                Err(_) => break,
+            }
+        }
+    }
+
+    pub fn print_summary(&self) {
+        let (finished, observed, in_flight, waiting) = {
+            let mut state = self.state.lock().unwrap();
+            let now = Instant::now();
+            let waiting = state.retries.values().filter(|r| r.retry_at > now).count();
+            (std::mem::take(&mut state.finished), state.containers.len(), state.in_flight.len(), waiting)
+        };
+
+        if !finished.is_empty() {
+            println!("\n[INFO] Contenedores eliminados y creados:");
+            let mut table = Table::new();
+            table.add_row(row!["Container ID", "Categoría", "Nombre", "Operación"]);
+            for done in &finished {
+                table.add_row(row![&done.id[..done.id.len().min(12)], done.category, done.name, done.action]);
+            }
+            table.printstd();
+        } else {
+            println!("\n[INFO] No se eliminaron ni crearon contenedores.");
+        }
+        println!(
+            "[INFO] Reconciliador: {} contenedores observados, {} operaciones en curso, {} esperando reintento",
+            observed, in_flight, waiting
+        );
+    }
+}
+
+async fn worker(docker: Docker, jobs: Arc<tokio::sync::Mutex<mpsc::Receiver<Job>>>, state: Arc<Mutex<State>>) {
+    loop {
+        let job = match jobs.lock().await.recv().await {
+            Some(job) => job,
+            None => return,
+        };
+        let key = job.key();
+        let result = match tokio::time::timeout(DOCKER_OP_TIMEOUT, run_job(&docker, job)).await {
+            Ok(result) => result,
+            Err(_) => Err(format!("La operación sobre {} excedió {}s", key, DOCKER_OP_TIMEOUT.as_secs())),
+        };
+        state.lock().unwrap().finish(key, result);
+    }
+}
+
+fn not_found(e: &DockerError) -> bool {
+    matches!(e, DockerError::DockerResponseServerError { status_code: 404, .. })
+}
+
+async fn run_job(docker: &Docker, job: Job) -> Result<Finished, String> {
+    match job {
+        Job::Remove { id, name, category } => {
+            let options = Some(RemoveContainerOptions { force: true, ..Default::default() });
+            match docker.remove_container(&id, options).await {
+                // Si ya no existe el resultado es el mismo
+                Ok(_) => Ok(Finished { action: "eliminado", id, name, category }),
+                Err(e) if not_found(&e) => Ok(Finished { action: "eliminado", id, name, category }),
+                Err(e) => Err(format!("Error al eliminar contenedor {} ({}): {:?}", name, id, e)),
+            }
+        }
+        Job::Create { category } => {
+            let spec = CATEGORIES.iter().find(|spec| spec.category == category).unwrap();
+            let nanos = SystemTime::now().duration_since(UNIX_EPOCH).unwrap_or_default().subsec_nanos();
+            let name = format!("stress_{}_r{:08x}", spec.name_type, nanos);
+            let config = Config {
+                image: Some(STRESS_IMAGE.to_string()),
+                cmd: Some(vec!["sh".to_string(), "-c".to_string(), format!("exec stress {}", spec.stress_args)]),
+                ..Default::default()
+            };
+
+            let created = docker
+                .create_container(Some(CreateContainerOptions { name: name.clone(), platform: None }), config)
+                .await
+                .map_err(|e| format!("Error al crear contenedor {}: {:?}", name, e))?;
+            docker
+                .start_container(&created.id, None::<StartContainerOptions<String>>)
+                .await
+                .map_err(|e| format!("Error al arrancar contenedor {}: {:?}", name, e))?;
+            Ok(Finished { action: "creado", id: created.id, name, category })
+        }
+    }
+}
+
+async fn list_managed(docker: &Docker) -> Result<HashMap<String, Observed>, DockerError> {
+    let containers = docker
+        .list_containers(Some(ListContainersOptions::<String> { all: true, ..Default::default() }))
+        .await?;
+
+    let mut observed = HashMap::new();
+    for summary in containers {
+        let name = summary.names.as_ref().and_then(|names| names.first()).cloned().unwrap_or_default();
+        let (Some(id), Some(category)) = (summary.id, category_of(&name)) else { continue };
+        let state = match summary.state.as_deref() {
+            Some("running") | Some("restarting") | Some("paused") => ContainerState::Running,
+            Some("created") => ContainerState::Created,
+            _ => ContainerState::Exited,
+        };
+        let created_ns = summary.created.unwrap_or(0).saturating_mul(1_000_000_000);
+        observed.insert(id, Observed { name: name.trim_start_matches('/').to_string(), category, created_ns, state });
+    }
+    Ok(observed)
+}
+
+// Mantiene el estado observado con los eventos de Docker; al caer el stream
+// se reconecta con espera exponencial y vuelve a listar
+async fn watch_events(docker: Docker, state: Arc<Mutex<State>>, resync_interval: Duration) {
+    let mut delay = BACKOFF_MIN;
+    loop {
+        let mut filters = HashMap::new();
+        filters.insert("type".to_string(), vec!["container".to_string()]);
+        filters.insert(
+            "event".to_string(),
+            ["create", "start", "die", "destroy"].iter().map(|e| e.to_string()).collect(),
+        );
+
+        // El stream se lee en su propia tarea: mientras corre una lista los
+        // eventos se acumulan en el canal en vez de quedarse sin leer
+        let (tx, mut events) = mpsc::channel(EVENTS_BUFFER);
+        let events_docker = docker.clone();
+        let forwarder = tokio::spawn(async move {
+            let mut stream = Box::pin(events_docker.events(Some(EventsOptions::<String> { filters, ..Default::default() })));
+            while let Some(event) = stream.next().await {
+                let failed = event.is_err();
+                if tx.send(event).await.is_err() || failed {
+                    break;
+                }
+            }
+        });
+        let mut resync = tokio::time::interval(resync_interval);
+        let mut settled = false;
+
+        loop {
+            tokio::select! {
+                event = events.recv() => match event {
+                    Some(Ok(event)) => state.lock().unwrap().apply(&event),
+                    Some(Err(e)) => {
+                        println!("\n[WARN] Se cortó el stream de eventos de Docker: {:?}", e);
+                        break;
+                    }
+                    None => {
+                        println!("\n[WARN] Docker cerró el stream de eventos");
+                        break;
+                    }
+                },
+                _ = resync.tick() => match list_managed(&docker).await {
+                    Ok(observed) => {
+                        state.lock().unwrap().resync(observed);
+                        delay = BACKOFF_MIN;
+                        // La primera lista puede correr antes de que Docker
+                        // reciba la petición de eventos; se repite al rato para
+                        // cubrir lo que pasó en ese intervalo
+                        if !settled {
+                            settled = true;
+                            resync.reset_after(EVENTS_SETTLE);
+                        }
+                    }
+                    Err(e) => {
+                        println!("\n[WARN] No se pudieron listar los contenedores: {:?}", e);
+                        break;
+                    }
+                },
+            }
+        }
+
+        forwarder.abort();
+        state.lock().unwrap().synced = false;
+        tokio::time::sleep(delay).await;
+        delay = (delay * 2).min(BACKOFF_MAX);
+    }
+}
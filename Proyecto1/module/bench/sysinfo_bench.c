@@ -0,0 +1,384 @@
+/*
+    Benchmark del núcleo de sysinfo_202202906 en espacio de usuario.
+
+    Arma en un directorio temporal un árbol falso system.slice/docker-<id>.scope
+    con los archivos que lee el módulo (cpu.stat, memory.current, memory.stat,
+    io.stat y *.pressure) para 10 a 1000 contenedores, y mide por pasada:
+      - recolección: la misma secuencia que sysinfo_collect_container con el
+        backend kernfs (get_cpu_stat, get_memory_usage y sysinfo_collect_files
+        de sysinfo_202202906_core.h), con open/pread en lugar de filp_open y
+        kernel_read y un bloque del mismo tamaño que scratch->buf
+      - salida: el JSON de cada contenedor con sysinfo_show_container en un
+        seq_file de una página, con el mismo reintento que seq_read
+    opens y reads se cuentan en cgroup_file_ops, y allocs son las reservas
+    hechas con kmalloc del shim durante la pasada, tanto del núcleo como del
+    seq_file.
+
+    Además compara lo parseado con lo que se escribió, así que un cambio en los
+    parsers que rompa algún valor hace fallar el benchmark (código de salida 1).
+
+    Uso: ./sysinfo_bench [-i pasadas] [contenedores ...]
+*/
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sysinfo_202202906_core.h"
+
+#define SCRATCH_BUF_SIZE 512        // Igual que sampler_scratch.buf en el módulo
+#define SEQ_PAGE_SIZE 4096          // Buffer inicial de seq_read
+
+static char *memory_stat_keys[] = { "file", "shmem", "pgfault" };
+static const unsigned int stats_windows[] = { 10, 60, 300 };
+
+static const struct sysinfo_show_opts show_opts = {
+    .throttling = true,
+    .pressure = true,
+    .io_devices = true,
+    .nr_memory_stat_keys = ARRAY_SIZE(memory_stat_keys),
+    .memory_stat_keys = memory_stat_keys,
+    .nr_stats_windows = ARRAY_SIZE(stats_windows),
+    .stats_windows = stats_windows,
+};
+
+// Se llena con memory_stat_fields_init, igual que en el módulo con memory_stat_keys=file,shmem,pgfault
+static struct stat_field memory_stat_fields[MEMORY_STAT_MAX_FIELDS];
+static struct sysinfo_collect_opts collect_opts = {
+    .pressure = true,
+    .nr_memory_stat_keys = ARRAY_SIZE(memory_stat_keys),
+    .memory_stat_fields = memory_stat_fields,
+};
+
+// Claves de un memory.stat real de cgroup v2, para que el parser recorra un archivo de tamaño realista
+static const char *const memory_stat_filler[] = {
+    "anon", "anon_thp", "file_thp", "shmem_thp", "file_mapped", "file_dirty", "file_writeback",
+    "swapcached", "inactive_anon", "active_anon", "inactive_file", "active_file", "unevictable",
+    "slab_reclaimable", "slab_unreclaimable", "slab", "workingset_refault_anon",
+    "workingset_refault_file", "workingset_activate_anon", "workingset_activate_file",
+    "workingset_restore_anon", "workingset_restore_file", "workingset_nodereclaim", "pgscan",
+    "pgsteal", "pgscan_kswapd", "pgscan_direct", "pgsteal_kswapd", "pgsteal_direct",
+    "pgmajfault", "pgrefill", "pgactivate", "pgdeactivate", "pglazyfree", "pglazyfreed",
+    "thp_fault_alloc", "thp_collapse_alloc", "sock", "vmalloc", "pagetables", "sec_pagetables",
+    "percpu", "zswap", "zswapped",
+};
+
+struct bench_counters {
+    unsigned long opens;
+    unsigned long reads;
+    unsigned long bytes;
+};
+
+static struct bench_counters counters;
+static char scratch_buf[SCRATCH_BUF_SIZE];
+static char path_buf[PATH_MAX];
+static struct io_stat scratch_io;
+
+static u64 now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Valores deterministas por contenedor, así la verificación no guarda nada aparte
+static u64 expected(unsigned int i, unsigned int field) {
+    return (u64)(i + 1) * 1000003ULL + field * 7919ULL;
+}
+
+static void write_file(const char *dir, const char *name, const char *fmt, ...) {
+    char path[PATH_MAX];
+    va_list args;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        exit(2);
+    }
+    va_start(args, fmt);
+    vfprintf(f, fmt, args);
+    va_end(args);
+    fclose(f);
+}
+
+static void container_dir(char *dst, size_t size, const char *root, unsigned int i) {
+    snprintf(dst, size, "%s/system.slice/docker-%016x%016x%016x%016x.scope", root, i, i * 31U, i * 17U, i * 7U);
+}
+
+static void make_container(const char *root, unsigned int i) {
+    char dir[PATH_MAX], memstat[4096];
+    size_t len = 0;
+
+    container_dir(dir, sizeof(dir), root, i);
+    if (mkdir(dir, 0755) < 0) {
+        perror(dir);
+        exit(2);
+    }
+
+    write_file(dir, "cpu.stat",
+               "usage_usec %llu\nuser_usec %llu\nsystem_usec %llu\nnr_periods %llu\n"
+               "nr_throttled %llu\nthrottled_usec %llu\nnr_bursts 0\nburst_usec 0\n",
+               expected(i, 0), expected(i, 1), expected(i, 2), expected(i, 3), expected(i, 4), expected(i, 5));
+    write_file(dir, "memory.current", "%llu\n", expected(i, 6) * 1024);
+
+    for (size_t k = 0; k < ARRAY_SIZE(memory_stat_filler) / 2; k++)
+        len += snprintf(memstat + len, sizeof(memstat) - len, "%s %llu\n", memory_stat_filler[k], expected(i, 100 + k));
+    len += snprintf(memstat + len, sizeof(memstat) - len, "kernel %llu\nkernel_stack %llu\nfile %llu\nshmem %llu\n",
+                    expected(i, 7), expected(i, 8), expected(i, 9), expected(i, 10));
+    for (size_t k = ARRAY_SIZE(memory_stat_filler) / 2; k < ARRAY_SIZE(memory_stat_filler); k++)
+        len += snprintf(memstat + len, sizeof(memstat) - len, "%s %llu\n", memory_stat_filler[k], expected(i, 100 + k));
+    snprintf(memstat + len, sizeof(memstat) - len, "pgfault %llu\n", expected(i, 11));
+    write_file(dir, "memory.stat", "%s", memstat);
+
+    write_file(dir, "io.stat",
+               "8:0 rbytes=%llu wbytes=%llu rios=%llu wios=%llu dbytes=0 dios=0\n"
+               "259:0 rbytes=%llu wbytes=%llu rios=%llu wios=%llu dbytes=0 dios=0\n",
+               expected(i, 12), expected(i, 13), expected(i, 14), expected(i, 15),
+               expected(i, 16), expected(i, 17), expected(i, 18), expected(i, 19));
+
+    for (int r = 0; r < NR_SYSINFO_PSI; r++)
+        write_file(dir, psi_files[r],
+                   "some avg10=%u.%02u avg60=%u.%02u avg300=0.00 total=%llu\n"
+                   "full avg10=%u.%02u avg60=%u.%02u avg300=0.00 total=%llu\n",
+                   i % 100, r, i % 50, r + 10, expected(i, 20 + r),
+                   i % 10, r + 20, i % 5, r + 30, expected(i, 30 + r));
+}
+
+static void make_tree(const char *root, unsigned int n) {
+    char dir[PATH_MAX];
+
+    snprintf(dir, sizeof(dir), "%s/system.slice", root);
+    if (mkdir(dir, 0755) < 0) {
+        perror(dir);
+        exit(2);
+    }
+    for (unsigned int i = 0; i < n; i++)
+        make_container(root, i);
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    return remove(path);
+}
+
+// cgroup_file_ops del módulo con open/pread: el archivo es el descriptor guardado en el puntero
+static int bench_file_open(const char *path, void **file) {
+    int fd;
+
+    counters.opens++;
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -errno;
+    *file = (void *)(intptr_t)fd;
+    return 0;
+}
+
+static ssize_t bench_file_read(void *file, char *buf, size_t len, loff_t *pos) {
+    ssize_t n = pread((int)(intptr_t)file, buf, len, *pos);
+
+    if (n < 0)
+        return -errno;
+    if (n > 0) {
+        counters.reads++;
+        *pos += n;
+    }
+    return n;
+}
+
+static void bench_file_close(void *file) {
+    close((int)(intptr_t)file);
+}
+
+static void bench_file_error(const char *path, int err) {
+}
+
+static const struct cgroup_file_ops bench_file_ops = {
+    .open = bench_file_open,
+    .read = bench_file_read,
+    .close = bench_file_close,
+    .error = bench_file_error,
+};
+
+static const struct cgroup_reader reader = {
+    .ops = &bench_file_ops,
+    .path = path_buf,
+    .buf = scratch_buf,
+    .buf_size = sizeof(scratch_buf),
+    .io = &scratch_io,
+};
+
+// Lo mismo que sysinfo_collect_container con el backend kernfs, sin los deltas que dependen de la muestra anterior
+static void collect_container(const char *dir, unsigned int i, struct container_sample *c) {
+    struct cpu_stat cs;
+
+    memset(c, 0, sizeof(*c));
+    snprintf(c->id, sizeof(c->id), "%016x%016x%016x%016x", i, i * 31U, i * 17U, i * 7U);
+    snprintf(c->comm, sizeof(c->comm), "stress");
+    snprintf(c->cmdline, sizeof(c->cmdline), "stress --cpu 1");
+    c->pid = 1000 + i;
+
+    get_cpu_stat(&reader, dir, &cs);
+    sysinfo_sample_cpu_stat(c, &cs);
+    sysinfo_collect_files(&reader, dir, c, get_memory_usage(&reader, dir), &collect_opts);
+}
+
+static int check(unsigned int i, const char *what, u64 got, u64 want) {
+    if (got == want)
+        return 0;
+    fprintf(stderr, "contenedor %u: %s = %llu, se esperaba %llu\n", i, what,
+            (unsigned long long)got, (unsigned long long)want);
+    return 1;
+}
+
+static int verify(unsigned int i, const struct container_sample *c) {
+    int bad = 0;
+
+    bad |= check(i, "usage_usec", c->cpu_usage_usec, expected(i, 0));
+    bad |= check(i, "nr_periods", c->nr_periods, expected(i, 3));
+    bad |= check(i, "nr_throttled", c->nr_throttled, expected(i, 4));
+    bad |= check(i, "throttled_usec", c->throttled_usec, expected(i, 5));
+    bad |= check(i, "memory.current", c->mem_usage_kb, expected(i, 6));
+    bad |= check(i, "file", c->memory_stat[0], expected(i, 9));
+    bad |= check(i, "shmem", c->memory_stat[1], expected(i, 10));
+    bad |= check(i, "pgfault", c->memory_stat[2], expected(i, 11));
+    bad |= check(i, "rios", c->io_read_ops, expected(i, 14) + expected(i, 18));
+    bad |= check(i, "wios", c->io_write_ops, expected(i, 15) + expected(i, 19));
+    bad |= check(i, "nr_io_devices", c->nr_io_devices, 2);
+    bad |= check(i, "io_devices[1].major", c->io_devices[1].major, 259);
+    for (int r = 0; r < NR_SYSINFO_PSI; r++) {
+        bad |= check(i, "some.avg10", c->psi[r].some.avg10, (i % 100) * 100 + r);
+        bad |= check(i, "some.avg60", c->psi[r].some.avg60, (i % 50) * 100 + r + 10);
+        bad |= check(i, "some.total", c->psi[r].some.total, expected(i, 20 + r));
+        bad |= check(i, "full.avg10", c->psi[r].full.avg10, (i % 10) * 100 + r + 20);
+        bad |= check(i, "full.total", c->psi[r].full.total, expected(i, 30 + r));
+    }
+    return bad;
+}
+
+/*
+    Como seq_read: los registros se acumulan en el buffer y se entregan al
+    llenarse; si un registro solo no cabe en el buffer vacío, se duplica el
+    buffer (una reserva) y se vuelve a generar
+*/
+static void emit(struct seq_file *m, const struct container_sample *c, unsigned int n) {
+    for (unsigned int i = 0; i < n; i++) {
+        size_t start = m->count;
+
+        sysinfo_show_container(m, &c[i], i == 0, NULL, &show_opts);
+        if (!seq_has_overflowed(m))
+            continue;
+
+        m->count = start;
+        if (start) {
+            counters.bytes += start;
+            m->count = 0;
+        } else {
+            kfree(m->buf);
+            m->size *= 2;
+            m->buf = kmalloc(m->size, GFP_KERNEL);
+            if (!m->buf) {
+                perror("malloc");
+                exit(2);
+            }
+        }
+        i--;
+    }
+    counters.bytes += m->count;
+    m->count = 0;
+}
+
+static int run(unsigned int n, unsigned int iterations) {
+    char root[] = "/tmp/sysinfo_bench.XXXXXX";
+    struct container_sample *samples;
+    struct seq_file m = { .size = SEQ_PAGE_SIZE };
+    char (*dirs)[PATH_MAX];
+    u64 collect_ns = 0, emit_ns = 0, best_collect = ~0ULL, t;
+    unsigned long allocs;
+    int bad = 0;
+
+    if (!mkdtemp(root)) {
+        perror("mkdtemp");
+        exit(2);
+    }
+    make_tree(root, n);
+
+    samples = calloc(n, sizeof(*samples));
+    dirs = calloc(n, sizeof(*dirs));
+    m.buf = kmalloc(m.size, GFP_KERNEL);
+    if (!samples || !dirs || !m.buf) {
+        perror("calloc");
+        exit(2);
+    }
+    // Como el registro del módulo: las rutas se arman una vez al dar de alta
+    for (unsigned int i = 0; i < n; i++)
+        container_dir(dirs[i], sizeof(dirs[i]), root, i);
+
+    memset(&counters, 0, sizeof(counters));
+    allocs = shim_allocs;
+    for (unsigned int it = 0; it < iterations; it++) {
+        t = now_ns();
+        for (unsigned int i = 0; i < n; i++)
+            collect_container(dirs[i], i, &samples[i]);
+        t = now_ns() - t;
+        collect_ns += t;
+        if (t < best_collect)
+            best_collect = t;
+
+        if (it == 0)
+            for (unsigned int i = 0; i < n; i++)
+                bad |= verify(i, &samples[i]);
+
+        t = now_ns();
+        emit(&m, samples, n);
+        emit_ns += now_ns() - t;
+    }
+
+    allocs = shim_allocs - allocs;
+
+    printf("%6u %12.1f %12.1f %10.2f %12.1f %8lu %8lu %10lu %7.2f\n", n,
+           collect_ns / 1e3 / iterations, best_collect / 1e3, collect_ns / 1e3 / iterations / n,
+           emit_ns / 1e3 / iterations, counters.opens / iterations, counters.reads / iterations,
+           counters.bytes / iterations, (double)allocs / iterations);
+
+    kfree(m.buf);
+    free(dirs);
+    free(samples);
+    nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    return bad;
+}
+
+int main(int argc, char **argv) {
+    static const unsigned int default_sizes[] = { 10, 100, 1000 };
+    unsigned int iterations = 20;
+    int opt, bad = 0;
+
+    collect_opts.nr_memory_stat_fields = memory_stat_fields_init(memory_stat_fields, memory_stat_keys,
+                                                                 ARRAY_SIZE(memory_stat_keys));
+
+    while ((opt = getopt(argc, argv, "i:")) != -1) {
+        if (opt != 'i' || atoi(optarg) <= 0) {
+            fprintf(stderr, "uso: %s [-i pasadas] [contenedores ...]\n", argv[0]);
+            return 2;
+        }
+        iterations = atoi(optarg);
+    }
+
+    printf("%6s %12s %12s %10s %12s %8s %8s %10s %7s\n", "conts", "collect_us", "best_us", "us/cont",
+           "emit_us", "opens", "reads", "bytes", "allocs");
+    if (optind < argc) {
+        for (int i = optind; i < argc; i++)
+            bad |= run(strtoul(argv[i], NULL, 10), iterations);
+    } else {
+        for (size_t i = 0; i < ARRAY_SIZE(default_sizes); i++)
+            bad |= run(default_sizes[i], iterations);
+    }
+
+    if (bad)
+        fprintf(stderr, "los valores parseados no coinciden con el árbol generado\n");
+    return bad;
+}
@@ -0,0 +1,113 @@
+/*
+    Capa mínima para compilar sysinfo_202202906_core.h en espacio de usuario.
+    Solo implementa lo que usa el núcleo, con la misma semántica que el
+    kernel: kstrto* rechaza basura al final (acepta un '\n'), y seq_printf
+    marca el seq_file como desbordado cuando no cabe el registro completo.
+    kmalloc cuenta las reservas en shim_allocs para el benchmark
+*/
+#ifndef _SYSINFO_SHIM_H
+#define _SYSINFO_SHIM_H
+
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>          // ssize_t y loff_t
+
+typedef unsigned int u32;
+typedef unsigned long long u64;  // Como en el kernel, para que %llu sirva igual
+
+#define TASK_COMM_LEN 16
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+static inline int shim_kstrtoull(const char *s, unsigned int base, unsigned long long *res) {
+    unsigned long long v = 0;
+    const char *p = s;
+
+    if (*p == '+')
+        p++;
+    if (*p < '0' || *p > '9')
+        return -EINVAL;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        unsigned int d = *p - '0';
+
+        if (d >= base || v > (~0ULL - d) / base)
+            return -ERANGE;
+        v = v * base + d;
+    }
+    if (*p == '\n')
+        p++;
+    if (*p)
+        return -EINVAL;
+    *res = v;
+    return 0;
+}
+
+static inline int kstrtou64(const char *s, unsigned int base, u64 *res) {
+    unsigned long long v;
+    int ret = shim_kstrtoull(s, base, &v);
+
+    if (!ret)
+        *res = v;
+    return ret;
+}
+
+static inline int kstrtouint(const char *s, unsigned int base, unsigned int *res) {
+    unsigned long long v;
+    int ret = shim_kstrtoull(s, base, &v);
+
+    if (ret)
+        return ret;
+    if (v > ~0U)
+        return -ERANGE;
+    *res = v;
+    return 0;
+}
+
+#define GFP_KERNEL 0
+
+static unsigned long shim_allocs;
+
+static inline void *kmalloc(size_t size, int flags) {
+    shim_allocs++;
+    return malloc(size);
+}
+
+static inline void kfree(const void *p) {
+    free((void *)p);
+}
+
+// Igual que en el kernel: si el texto no cabe, count queda en size y el que lee reintenta con más espacio
+struct seq_file {
+    char *buf;
+    size_t size;
+    size_t count;
+};
+
+static inline bool seq_has_overflowed(struct seq_file *m) {
+    return m->count == m->size;
+}
+
+__attribute__((format(printf, 2, 3)))
+static inline void seq_printf(struct seq_file *m, const char *fmt, ...) {
+    va_list args;
+    int len;
+
+    if (m->count < m->size) {
+        va_start(args, fmt);
+        len = vsnprintf(m->buf + m->count, m->size - m->count, fmt, args);
+        va_end(args);
+        if (len >= 0 && m->count + len < m->size) {
+            m->count += len;
+            return;
+        }
+    }
+    m->count = m->size;
+}
+
+#endif /* _SYSINFO_SHIM_H */
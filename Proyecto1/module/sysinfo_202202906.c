@@ -21,6 +21,40 @@
 #include <linux/time.h>
 #include <linux/list.h>
 #include <linux/delay.h>
+#include <linux/workqueue.h>
+#include <linux/mutex.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/moduleparam.h>
+#include <linux/kref.h>
+#include <linux/hashtable.h>
+#include <linux/jhash.h>
+#include <linux/overflow.h>
+#include <linux/version.h>
+#include <linux/memcontrol.h>
+#include <linux/page_counter.h>
+#include <linux/u64_stats_sync.h>
+#include <linux/mm_types.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/atomic.h>
+#include <linux/tick.h>
+#include <linux/kernel_stat.h>
+#include <linux/percpu.h>
+#include <linux/sort.h>
+#include <linux/tracepoint.h>
+#include <linux/spinlock.h>
+#include <linux/rcupdate.h>
+#include <linux/debugfs.h>
+#include <linux/log2.h>
+#include <net/genetlink.h>
+
+#include "sysinfo_202202906.h"
+#include "sysinfo_202202906_core.h"
+
+#define CREATE_TRACE_POINTS
+#include "sysinfo_202202906_trace.h"
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("202202906");
@@ -28,12 +62,364 @@ MODULE_DESCRIPTION("Módulo para monitorear memoria, CPU y procesos Docker");
 MODULE_VERSION("1.0");
 
 #define PROC_NAME "sysinfo_202202906"
-#define MAX_CMDLINE_LENGTH 256
+#define DELTA_PROC_NAME "sysinfo_202202906_delta"
+#define EXITED_PROC_NAME "sysinfo_202202906_exited"
 #define CONTAINER_ID_LENGTH 12
 #define CONTAINER_PREFIX "stress_"
+#define REGISTRY_HASH_BITS 10
+#define TASK_CACHE_HASH_BITS 8
+#define DISCOVERY_BATCH 64
+#define REPROBE_WINDOW_NS (10 * NSEC_PER_SEC)  // Tiempo tras el alta en que se vuelve a probar un contenedor ignorado
+#define MIN_SAMPLE_PERIOD_MS 100U
+#define DELTA_HASH_BITS 6
+#define LIFECYCLE_MAX_PENDING 1024  // Eventos de alta/baja en espera del sampler
+#define STATS_HIST_SUB_BITS 3      // 8 subcubetas por potencia de 2, error relativo máximo de 12.5%
+#define STATS_HIST_BUCKETS ((32 - STATS_HIST_SUB_BITS + 1) << STATS_HIST_SUB_BITS)
+
+// Periodo del muestreo en segundo plano, se puede cambiar en /sys/module/sysinfo_202202906/parameters
+static unsigned int sample_period_ms = 1000;
+module_param(sample_period_ms, uint, 0644);
+MODULE_PARM_DESC(sample_period_ms, "Periodo de muestreo de los contenedores en milisegundos (minimo 100)");
+
+static char *collect_backend = "direct";
+module_param(collect_backend, charp, 0444);
+MODULE_PARM_DESC(collect_backend, "Origen de los contadores: direct (struct cgroup) o kernfs (archivos de cgroupfs)");
+
+static bool poll_on_sample = true;
+module_param(poll_on_sample, bool, 0644);
+MODULE_PARM_DESC(poll_on_sample, "Despertar a poll() con cada muestra nueva (si es 0, solo con altas, bajas y umbrales)");
+
+static unsigned int poll_cpu_threshold;
+module_param(poll_cpu_threshold, uint, 0644);
+MODULE_PARM_DESC(poll_cpu_threshold, "Umbral de CPU en centésimas de porcentaje que despierta a poll() al cruzarse (0 = desactivado)");
+
+static unsigned int poll_mem_threshold;
+module_param(poll_mem_threshold, uint, 0644);
+MODULE_PARM_DESC(poll_mem_threshold, "Umbral de memoria en centésimas de porcentaje que despierta a poll() al cruzarse (0 = desactivado)");
+
+static unsigned int ring_slots = 8;
+module_param(ring_slots, uint, 0444);
+MODULE_PARM_DESC(ring_slots, "Cantidad de muestras que guarda el anillo mapeable");
+
+static unsigned int ring_max_records = 256;
+module_param(ring_max_records, uint, 0444);
+MODULE_PARM_DESC(ring_max_records, "Contenedores por muestra en el anillo mapeable");
+
+static unsigned int delta_cpu_threshold = 100;
+module_param(delta_cpu_threshold, uint, 0644);
+MODULE_PARM_DESC(delta_cpu_threshold, "Modo delta: cambio de CPU en centésimas de porcentaje para volver a enviar un contenedor");
+
+static unsigned int delta_mem_threshold = 100;
+module_param(delta_mem_threshold, uint, 0644);
+MODULE_PARM_DESC(delta_mem_threshold, "Modo delta: cambio de memoria en centésimas de porcentaje para volver a enviar un contenedor");
+
+static unsigned int delta_io_threshold_kb = 1024;
+module_param(delta_io_threshold_kb, uint, 0644);
+MODULE_PARM_DESC(delta_io_threshold_kb, "Modo delta: KB leídos o escritos para volver a enviar un contenedor");
+
+static unsigned int stats_windows[STATS_MAX_WINDOWS] = { 10, 60, 300 };
+static int nr_stats_windows = 3;
+module_param_array(stats_windows, uint, &nr_stats_windows, 0444);
+MODULE_PARM_DESC(stats_windows, "Ventanas en segundos de las estadísticas por contenedor, hasta 4 (por defecto 10,60,300)");
+
+static unsigned int stats_ring_size = 512;
+module_param(stats_ring_size, uint, 0444);
+MODULE_PARM_DESC(stats_ring_size, "Muestras recientes que guarda cada contenedor para las estadísticas (0 = desactivadas)");
+
+static char *memory_stat_keys[MAX_MEMORY_STAT_KEYS];
+static int nr_memory_stat_keys;
+module_param_array(memory_stat_keys, charp, &nr_memory_stat_keys, 0444);
+MODULE_PARM_DESC(memory_stat_keys, "Claves adicionales de memory.stat que se exportan por contenedor, separadas por coma (ej. file,shmem,pgfault)");
+
+static bool io_per_device;
+module_param(io_per_device, bool, 0644);
+MODULE_PARM_DESC(io_per_device, "Exportar el detalle de io.stat por dispositivo además del total");
+
+static bool collect_pressure = true;
+module_param(collect_pressure, bool, 0644);
+MODULE_PARM_DESC(collect_pressure, "Leer cpu.pressure, memory.pressure e io.pressure (PSI) de cada contenedor");
+
+static bool collect_throttling = true;
+module_param(collect_throttling, bool, 0644);
+MODULE_PARM_DESC(collect_throttling, "Leer los contadores de throttling de CFS de cpu.stat con el backend direct");
+
+static char *discovery = "tasks";
+module_param(discovery, charp, 0444);
+MODULE_PARM_DESC(discovery, "Descubrimiento de contenedores: tasks (for_each_process) o cgroups (descendientes de docker_parent)");
+
+static char *docker_parent = "/system.slice";
+module_param(docker_parent, charp, 0444);
+MODULE_PARM_DESC(docker_parent, "Cgroup padre de los scopes de Docker, relativo a la raíz de cgroup v2");
+
+static char *cgroup_root = "/sys/fs/cgroup";
+module_param(cgroup_root, charp, 0444);
+MODULE_PARM_DESC(cgroup_root, "Punto de montaje de cgroup v2");
+
+static bool lifecycle_events = true;
+module_param(lifecycle_events, bool, 0444);
+MODULE_PARM_DESC(lifecycle_events, "Seguir el alta y la baja de contenedores con los tracepoints cgroup_mkdir/rmdir y sched_process_exec/exit");
+
+static unsigned int exited_max = 256;
+module_param(exited_max, uint, 0444);
+MODULE_PARM_DESC(exited_max, "Contenedores terminados que se conservan en /proc/sysinfo_202202906_exited");
+
+// Punto del anillo de muestras recientes de un contenedor
+struct stat_point {
+    u64 timestamp_ns;
+    u32 value[NR_STAT_METRICS];
+};
+
+// Eventos de una pasada del sampler que pueden despertar a poll()
+enum {
+    SYSINFO_EV_SAMPLE    = 1 << 0,
+    SYSINFO_EV_ADDED     = 1 << 1,
+    SYSINFO_EV_REMOVED   = 1 << 2,
+    SYSINFO_EV_THRESHOLD = 1 << 3,
+};
+
+// Tiempos acumulados de una CPU en ns, con el mismo criterio que /proc/stat
+struct cpu_times {
+    u64 user;       // user + nice (incluye guest)
+    u64 system;
+    u64 idle;
+    u64 iowait;
+    u64 irq;
+    u64 softirq;
+    u64 steal;
+};
+
+// Uso de CPU en la ventana entre dos muestras, en centésimas de porcentaje
+struct cpu_sample {
+    unsigned int usage;             // Todo lo que no es idle ni iowait
+    unsigned int user;
+    unsigned int system;
+    unsigned int idle;
+    unsigned int iowait;
+    unsigned int irq;
+    unsigned int softirq;
+    unsigned int steal;
+    bool online;
+};
+
+// Resultado completo de una pasada del sampler
+struct sysinfo_snapshot {
+    struct kref ref;
+    unsigned int events;
+    u64 generation;
+    u64 timestamp_ns;
+    unsigned long total_mb;
+    unsigned long free_mb;
+    unsigned long used_mb;
+    unsigned long cpu_usage_total;
+    struct cpu_sample cpu;              // Agregado de todas las CPUs
+    struct cpu_sample *cpus;            // nr_cpus elementos, en la misma reserva después de containers
+    unsigned int nr_cpus;
+    unsigned int capacity;              // Registros reservados en containers, puede ser mayor que count
+    int count;
+    struct container_sample containers[];
+};
+
+/*
+    Registro persistente de contenedores indexado por el ID completo.
+    Guarda el estado que no cambia entre muestras (cgroup, PID, cmdline) y
+    los últimos contadores para calcular deltas. Solo lo modifica el sampler,
+    que corre en una workqueue ordenada, por lo que no necesita lock propio
+*/
+struct container_entry {
+    struct hlist_node node;
+    u32 hash;
+    char id[CONTAINER_ID_MAX];
+    struct cgroup_subsys_state *css;    // css de memoria del contenedor, css->cgroup es su cgroup
+    char *cgroup_dir;                   // Directorio del cgroup en cgroupfs, sin asumir la jerarquía de systemd
+    pid_t pid;
+    char comm[TASK_COMM_LEN];
+    char cmdline[MAX_CMDLINE_LENGTH];
+    bool ignored;                       // Contenedor sin proceso "stress"; pasado REPROBE_WINDOW_NS no se revisa otra vez
+    bool over_cpu;                      // Estado respecto a poll_cpu_threshold en la última muestra
+    bool over_mem;                      // Estado respecto a poll_mem_threshold en la última muestra
+    bool tracked;                       // Alta por cgroup_mkdir: la baja la da cgroup_rmdir, no el barrido
+    u64 seen_gen;                       // Última pasada del sampler que lo encontró
+    u64 start_ns;                       // Tiempo real del alta: cgroup_mkdir si tracked, si no la primera pasada que lo vio
+    u64 exit_ns;                        // Tiempo real en que terminó el proceso principal, 0 si sigue vivo
+    u64 nr_samples;
+    unsigned long max_mem_kb;
+    u64 last_sample_ns;
+    unsigned long last_cpu_usage_usec;
+    unsigned long last_mem_kb;
+    unsigned long last_read_kb;
+    unsigned long last_write_kb;
+    unsigned long last_io_read_ops;
+    unsigned long last_io_write_ops;
+    struct stat_point *points;          // Anillo de stats_ring_size muestras, se reserva en la primera
+    unsigned int points_head;
+    unsigned int nr_points;
+};
+
+/*
+    Backend de recolección: "direct" toma memory.current y usage_usec del
+    struct cgroup (page_counter del memcg y rstat por CPU) sin abrir archivos;
+    "kernfs" lee memory.current y cpu.stat desde cgroupfs como antes.
+    memory.stat e io.stat no tienen equivalente exportado a módulos y se leen
+    de cgroupfs en ambos casos, en la ruta del propio cgroup del contenedor
+*/
+struct collect_backend {
+    const char *name;
+    void (*cpu_stat)(struct container_entry *e, struct cpu_stat *cs);
+    unsigned long (*memory_kb)(struct container_entry *e);
+};
+
+static DEFINE_HASHTABLE(container_registry, REGISTRY_HASH_BITS);
+static DEFINE_PER_CPU(struct cpu_times, cpu_prev);     // Tiempos de la muestra anterior, solo los usa el sampler
+static u32 stats_hist[NR_STAT_METRICS][STATS_HIST_BUCKETS];   // Histogramas de trabajo del sampler
+
+// Contenedor nuevo encontrado bajo RCU en el descubrimiento por cgroups
+struct pending_cgroup {
+    struct cgroup *cgrp;
+    char id[CONTAINER_ID_MAX];
+};
+
+/*
+    Buffers de trabajo del sampler, reservados una sola vez en sysinfo_init.
+    El sampler corre en una workqueue ordenada, así que nunca hay dos pasadas
+    usándolos a la vez; con esto una pasada no reserva memoria por contenedor
+*/
+struct sampler_scratch {
+    char path[PATH_MAX];                // Rutas de cgroupfs y de cgroups
+    char buf[512];                      // Bloque de lectura de memory.current, memory.stat, cpu.stat e io.stat
+    struct pending_cgroup pending[DISCOVERY_BATCH];
+    struct io_stat io;
+    struct cgroup_reader reader;        // Lectura de cgroupfs del núcleo sobre path, buf e io
+    struct task_struct **tasks;         // Procesos candidatos del descubrimiento por tareas, crece según haga falta
+    unsigned int max_tasks;
+    struct container_sample final;      // Muestra final de un contenedor que termina, no va a ningún snapshot
+};
+
+static struct sampler_scratch *scratch;
+static struct kmem_cache *entry_cache;
+
+/*
+    Caché de procesos del descubrimiento por tareas: el ID del contenedor y
+    la cmdline no cambian en la vida de un proceso, así que se calculan una
+    sola vez por (pid, start_time). Una entrada se invalida cuando el proceso
+    termina (tracepoint sched_process_exit) o cuando deja de aparecer en una
+    pasada. También guarda los procesos que llegan por sched_process_exec.
+    Solo el sampler agrega y libera entradas, bajo task_cache_lock; el probe
+    de salida solo las marca, así el sampler las lee sin lock
+*/
+struct task_cache_entry {
+    struct hlist_node node;
+    pid_t pid;
+    u64 start_time;
+    u64 seen_gen;
+    bool exited;
+    bool is_container;                  // false si el proceso no está en un scope de Docker
+    u32 hash;                           // jhash del ID, para el registro
+    char id[CONTAINER_ID_MAX];
+    char cmdline[MAX_CMDLINE_LENGTH];
+};
+
+static DEFINE_HASHTABLE(task_cache, TASK_CACHE_HASH_BITS);
+static DEFINE_SPINLOCK(task_cache_lock);
+static struct kmem_cache *task_cache_cachep;
+static bool discover_cgroups;
+static unsigned int registry_count;
+static u64 sampler_generation;
+
+/*
+    El sampler llena un snapshot nuevo, lo publica con rcu_assign_pointer y
+    no lo vuelve a modificar. Cada lectura toma una referencia al snapshot
+    publicado dentro de rcu_read_lock, sin ningún lock compartido con el
+    sampler, y la conserva entre llamadas a read(): todos los lectores
+    formatean la misma muestra y ninguno repite la recolección. El snapshot
+    reemplazado suelta la referencia de publicación después de un periodo
+    de gracia, cuando ya ningún lector puede estar por tomarla
+*/
+static struct sysinfo_snapshot __rcu *current_snapshot;
+
+/*
+    El último snapshot que se queda sin referencias no se libera, se guarda
+    como repuesto y la siguiente pasada lo reutiliza si le alcanza la
+    capacidad. Con una cantidad estable de contenedores el sampler no reserva
+*/
+static struct sysinfo_snapshot *spare_snapshot;
+static DEFINE_SPINLOCK(spare_lock);
+static DECLARE_WAIT_QUEUE_HEAD(sysinfo_wait);
+static atomic_t sysinfo_event_seq = ATOMIC_INIT(0);
+static struct workqueue_struct *sampler_wq;
+static struct delayed_work sampler_work;
+
+/*
+    Autoinstrumentación en debugfs (/sys/kernel/debug/sysinfo_202202906):
+    contadores del trabajo del propio módulo e histogramas de latencia con
+    cubetas en potencias de 2 de nanosegundos. Escribir en "reset" los pone en 0
+*/
+#define LATENCY_HIST_BUCKETS 32
+
+enum {
+    DBG_CGROUP_OPENS,
+    DBG_CGROUP_OPEN_ERRORS,
+    DBG_CGROUP_READS,
+    DBG_ALLOC_FAILURES,
+    DBG_CONTAINERS_SKIPPED,
+    DBG_LIFECYCLE_EVENTS,
+    DBG_LIFECYCLE_DROPPED,
+    NR_DBG_COUNTERS,
+};
+
+static const char *const dbg_counter_names[NR_DBG_COUNTERS] = {
+    [DBG_CGROUP_OPENS] = "cgroup_opens",
+    [DBG_CGROUP_OPEN_ERRORS] = "cgroup_open_errors",
+    [DBG_CGROUP_READS] = "cgroup_reads",
+    [DBG_ALLOC_FAILURES] = "alloc_failures",
+    [DBG_CONTAINERS_SKIPPED] = "containers_skipped",
+    [DBG_LIFECYCLE_EVENTS] = "lifecycle_events",
+    [DBG_LIFECYCLE_DROPPED] = "lifecycle_dropped",
+};
+
+struct latency_hist {
+    atomic64_t count;
+    atomic64_t sum_ns;
+    atomic64_t max_ns;
+    atomic64_t buckets[LATENCY_HIST_BUCKETS];   // Cubeta b: [2^b, 2^(b+1)) ns
+};
+
+static atomic64_t dbg_counters[NR_DBG_COUNTERS];
+static struct latency_hist show_latency;        // Lectura completa de /proc/sysinfo_202202906
+static struct latency_hist sample_latency;      // Pasada completa del sampler
+static struct latency_hist container_latency;   // Recolección de un contenedor
+static struct dentry *debug_dir;
+
+static void dbg_inc(int counter) {
+    atomic64_inc(&dbg_counters[counter]);
+}
+
+static void dbg_add(int counter, long n) {
+    atomic64_add(n, &dbg_counters[counter]);
+}
+
+static void latency_record(struct latency_hist *h, u64 ns) {
+    unsigned int b = ns ? min_t(unsigned int, ilog2(ns), LATENCY_HIST_BUCKETS - 1) : 0;
+    s64 max = atomic64_read(&h->max_ns);
+
+    atomic64_inc(&h->count);
+    atomic64_add(ns, &h->sum_ns);
+    atomic64_inc(&h->buckets[b]);
+    while (ns > max && !atomic64_try_cmpxchg(&h->max_ns, &max, ns))
+        ;
+}
+
+// Marca de inicio de una fase del sampler; el costo sin perf/ftrace es una lectura del reloj
+static u64 phase_start(u64 gen, unsigned int phase) {
+    trace_sysinfo_phase_start(gen, phase);
+    return ktime_get_ns();
+}
+
+static void phase_end(u64 gen, unsigned int phase, unsigned int count, u64 start) {
+    trace_sysinfo_phase_end(gen, phase, count, ktime_get_ns() - start);
+}
 
-// Función para obtener la línea de comandos de un proceso
-static char *get_process_cmdline(struct task_struct *task) {
+// Función para obtener la línea de comandos de un proceso, se escribe en cmdline (MAX_CMDLINE_LENGTH bytes)
+static int get_process_cmdline(struct task_struct *task, char *cmdline) {
 
     /* 
         Creamos una estructura mm_struct para obtener la información de memoria
@@ -43,22 +429,14 @@ static char *get_process_cmdline(struct task_struct *task) {
         Creamos variables para recorrer la línea de comandos
     */
     struct mm_struct *mm;
-    char *cmdline, *p;
+    char *p;
     unsigned long arg_start, arg_end, env_start;
     int i, len;
 
-
-    // Reservamos memoria para la línea de comandos
-    cmdline = kmalloc(MAX_CMDLINE_LENGTH, GFP_KERNEL);
-    if (!cmdline)
-        return NULL;
-
     // Obtenemos la información de memoria
     mm = get_task_mm(task);
-    if (!mm) {
-        kfree(cmdline);
-        return NULL;
-    }
+    if (!mm)
+        return -ESRCH;
 
     /* 
        1. Primero obtenemos el bloqueo de lectura de la estructura mm_struct para una lectura segura
@@ -84,8 +462,7 @@ static char *get_process_cmdline(struct task_struct *task) {
     */
     if (access_process_vm(task, arg_start, cmdline, len, 0) != len) {
         mmput(mm);
-        kfree(cmdline);
-        return NULL;
+        return -EFAULT;
     }
 
     // Agregamos un caracter nulo al final de la línea de comandos
@@ -99,79 +476,185 @@ static char *get_process_cmdline(struct task_struct *task) {
 
     // Liberamos la estructura mm_struct
     mmput(mm);
-    return cmdline;
+    return len;
 }
 
-static char *get_container_id(struct task_struct *task) {
-    struct cgroup *cgrp;
-    char *container_id = NULL;
-    char *path_buffer;
+// Extrae el ID de una ruta ".../docker-<id>.scope"; modifica la ruta y devuelve el ID dentro de ella
+static char *container_id_from_path(char *path) {
     char *docker_pos;
     char *end_pos;
 
-    /* Asignar memoria dinámicamente para evitar stack overflow */
-    path_buffer = kmalloc(PATH_MAX, GFP_KERNEL);
-    if (!path_buffer)
+    /* Buscar "docker-" en la ruta */
+    docker_pos = strstr(path, "docker-");
+    if (!docker_pos)
         return NULL;
+    docker_pos += 7; // Saltar "docker-"
+
+    /* Buscar el final del ID del contenedor antes de ".scope" */
+    end_pos = strstr(docker_pos, ".scope");
+    if (end_pos)
+        *end_pos = '\0';
+
+    return *docker_pos ? docker_pos : NULL;
+}
+
+// Copia el ID del contenedor de la tarea en container_id (CONTAINER_ID_MAX bytes)
+static bool get_container_id(struct task_struct *task, char *container_id) {
+    struct cgroup *cgrp;
+    char *path_buffer = scratch->path;
+    char *id;
 
     /* Obtener el cgroup asociado */
     cgrp = task_cgroup(task, memory_cgrp_id);
-    if (!cgrp) {
-        kfree(path_buffer);
-        return NULL;
-    }
+    if (!cgrp)
+        return false;
 
     /* Obtener la ruta del cgroup */
-    if (cgroup_path(cgrp, path_buffer, PATH_MAX) <= 0) {
-        kfree(path_buffer);
-        return NULL;
+    if (cgroup_path(cgrp, path_buffer, PATH_MAX) <= 0)
+        return false;
+
+    /* Copiar el ID completo + terminador nulo */
+    id = container_id_from_path(path_buffer);
+    if (!id)
+        return false;
+
+    strscpy(container_id, id, CONTAINER_ID_MAX);
+    return true;
+}
+
+// Lee el primer PID de cgroup.procs, que en un contenedor es su proceso principal
+static pid_t get_first_cgroup_pid(const char *cgroup_dir) {
+    char *path = scratch->path;
+    struct file *filp;
+    char buf[16];
+    loff_t pos = 0;
+    ssize_t bytes_read;
+    char *end;
+    int nr = 0;
+
+    snprintf(path, PATH_MAX, "%s/cgroup.procs", cgroup_dir);
+    dbg_inc(DBG_CGROUP_OPENS);
+    filp = filp_open(path, O_RDONLY, 0);
+    if (IS_ERR(filp)) {
+        dbg_inc(DBG_CGROUP_OPEN_ERRORS);
+        trace_sysinfo_cgroup_read_error(path, PTR_ERR(filp));
+        return 0;
     }
 
-    pr_info("Cgroup path: %s\n", path_buffer);
+    dbg_inc(DBG_CGROUP_READS);
+    bytes_read = kernel_read(filp, buf, sizeof(buf) - 1, &pos);
+    filp_close(filp, NULL);
+    if (bytes_read <= 0)
+        return 0;
 
-    /* Buscar "docker-" en la ruta */
-    docker_pos = strstr(path_buffer, "docker-");
-    if (docker_pos) {
-        docker_pos += 7; // Saltar "docker-"
-
-        /* Buscar el final del ID del contenedor antes de ".scope" */
-        end_pos = strstr(docker_pos, ".scope");
-        if (end_pos) {
-            *end_pos = '\0';
-        }
+    buf[bytes_read] = '\0';
+    end = strchr(buf, '\n');
+    if (end)
+        *end = '\0';
+    if (kstrtoint(buf, 10, &nr) < 0)
+        return 0;
+    return nr;
+}
 
-        /* Calcular la longitud del ID completo */
-        size_t id_length = strlen(docker_pos);
-        if (id_length > 0) {
-            /* Asignar memoria para el ID completo + terminador nulo */
-            container_id = kmalloc(id_length + 1, GFP_KERNEL);
-            if (container_id) {
-                strncpy(container_id, docker_pos, id_length);
-                container_id[id_length] = '\0'; // Asegurar terminación
-            }
-        }
+static struct task_struct *get_representative_task(const char *cgroup_dir) {
+    struct task_struct *task = NULL;
+    struct pid *pid;
+    pid_t nr;
+
+    nr = get_first_cgroup_pid(cgroup_dir);
+    if (nr <= 0)
+        return NULL;
+
+    pid = find_get_pid(nr);
+    if (pid) {
+        task = get_pid_task(pid, PIDTYPE_PID);
+        put_pid(pid);
     }
+    return task;
+}
+
+static void read_cpu_times(int cpu, struct cpu_times *t) {
+    struct kernel_cpustat kcs;
+    u64 us = -1ULL;
+
+    kcpustat_cpu_fetch(&kcs, cpu);
+    t->user = kcs.cpustat[CPUTIME_USER] + kcs.cpustat[CPUTIME_NICE];
+    t->system = kcs.cpustat[CPUTIME_SYSTEM];
+    t->irq = kcs.cpustat[CPUTIME_IRQ];
+    t->softirq = kcs.cpustat[CPUTIME_SOFTIRQ];
+    t->steal = kcs.cpustat[CPUTIME_STEAL];
+
+    // Con NOHZ kcpustat no acumula idle mientras la CPU duerme, se usa el reloj de tick-sched como /proc/stat
+    if (cpu_online(cpu))
+        us = get_cpu_idle_time_us(cpu, NULL);
+    t->idle = us == -1ULL ? kcs.cpustat[CPUTIME_IDLE] : us * NSEC_PER_USEC;
+
+    us = -1ULL;
+    if (cpu_online(cpu))
+        us = get_cpu_iowait_time_us(cpu, NULL);
+    t->iowait = us == -1ULL ? kcs.cpustat[CPUTIME_IOWAIT] : us * NSEC_PER_USEC;
+}
 
-    /* Liberar memoria del buffer */
-    kfree(path_buffer);
-    return container_id;
+// idle e iowait pueden venir de dos fuentes distintas, un retroceso cuenta como 0
+static u64 cpu_delta(u64 now, u64 prev) {
+    return now > prev ? now - prev : 0;
 }
 
+static unsigned int cpu_share(u64 part, u64 total) {
+    return total ? div64_u64(part * 10000, total) : 0;
+}
 
-static unsigned long get_cpu_usage(void) {
-    unsigned long user, nice, system, idle;
-    unsigned long total_usage, total_time;
+static void cpu_sample_fill(struct cpu_sample *s, const struct cpu_times *d) {
+    u64 total = d->user + d->system + d->idle + d->iowait + d->irq + d->softirq + d->steal;
+
+    s->usage = cpu_share(total - d->idle - d->iowait, total);
+    s->user = cpu_share(d->user, total);
+    s->system = cpu_share(d->system, total);
+    s->idle = cpu_share(d->idle, total);
+    s->iowait = cpu_share(d->iowait, total);
+    s->irq = cpu_share(d->irq, total);
+    s->softirq = cpu_share(d->softirq, total);
+    s->steal = cpu_share(d->steal, total);
+}
 
-    // Obtener datos de CPU desde kcpustat_cpu()
-    user = kcpustat_cpu(0).cpustat[CPUTIME_USER];
-    nice = kcpustat_cpu(0).cpustat[CPUTIME_NICE];
-    system = kcpustat_cpu(0).cpustat[CPUTIME_SYSTEM];
-    idle = kcpustat_cpu(0).cpustat[CPUTIME_IDLE];
+/*
+    Uso de CPU del host en la ventana desde la muestra anterior: recorre todas
+    las CPUs posibles, guarda sus tiempos en cpu_prev y llena el desglose por
+    CPU y el agregado del snapshot. La primera muestra cubre desde el arranque
+*/
+static unsigned long get_cpu_usage(struct sysinfo_snapshot *snap) {
+    struct cpu_times sum = {}, now, d;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        struct cpu_times *prev = per_cpu_ptr(&cpu_prev, cpu);
+
+        read_cpu_times(cpu, &now);
+        d.user = cpu_delta(now.user, prev->user);
+        d.system = cpu_delta(now.system, prev->system);
+        d.idle = cpu_delta(now.idle, prev->idle);
+        d.iowait = cpu_delta(now.iowait, prev->iowait);
+        d.irq = cpu_delta(now.irq, prev->irq);
+        d.softirq = cpu_delta(now.softirq, prev->softirq);
+        d.steal = cpu_delta(now.steal, prev->steal);
+        *prev = now;
+
+        if (cpu < snap->nr_cpus) {
+            snap->cpus[cpu].online = cpu_online(cpu);
+            cpu_sample_fill(&snap->cpus[cpu], &d);
+        }
 
-    total_time = user + nice + system + idle;
-    total_usage = (user + nice + system) * 10000 / total_time; // Escalado a 2 decimales
+        sum.user += d.user;
+        sum.system += d.system;
+        sum.idle += d.idle;
+        sum.iowait += d.iowait;
+        sum.irq += d.irq;
+        sum.softirq += d.softirq;
+        sum.steal += d.steal;
+    }
 
-    return total_usage;
+    cpu_sample_fill(&snap->cpu, &sum);
+    return snap->cpu.usage;
 }
 
 // Helper function to check if a process is a parent (has children)
@@ -180,511 +663,2259 @@ static int is_parent_process(struct task_struct *task) {
 }
 
 
-static unsigned long get_memory_usage(const char *container_id) {
-    char *path = NULL;
-    struct file *filp = NULL;
-    char *buf = NULL;
-    loff_t pos = 0;
-    ssize_t bytes_read;
-    unsigned long mem_usage = 0;
-    int ret;
+/*
+    Archivos de cgroupfs para el núcleo: filp_open y kernel_read, con los
+    contadores de debugfs y el tracepoint de error de lectura
+*/
+static int cgroup_file_open(const char *path, void **file) {
+    struct file *filp;
 
-    // Allocate memory for the path
-    path = kmalloc(PATH_MAX, GFP_KERNEL);
-    if (!path) {
-        printk(KERN_WARNING "Failed to allocate memory for path\n");
-        return 0;
+    dbg_inc(DBG_CGROUP_OPENS);
+    filp = filp_open(path, O_RDONLY, 0);
+    if (IS_ERR(filp)) {
+        dbg_inc(DBG_CGROUP_OPEN_ERRORS);
+        return PTR_ERR(filp);
     }
+    *file = filp;
+    return 0;
+}
 
-    // Allocate memory for the buffer (increased to 128 bytes for safety)
-    buf = kmalloc(128, GFP_KERNEL);
-    if (!buf) {
-        printk(KERN_WARNING "Failed to allocate memory for buffer\n");
-        goto free_path;
-    }
+static ssize_t cgroup_file_read(void *file, char *buf, size_t len, loff_t *pos) {
+    ssize_t n = kernel_read(file, buf, len, pos);
 
-    // Construct the path to the memory.current file
-    snprintf(path, PATH_MAX, "/sys/fs/cgroup/system.slice/docker-%s.scope/memory.current", container_id);
+    if (n > 0)
+        dbg_inc(DBG_CGROUP_READS);
+    return n;
+}
 
-    // Open the file
-    filp = filp_open(path, O_RDONLY, 0);
-    if (IS_ERR(filp)) {
-        printk(KERN_WARNING "Failed to open %s: %ld\n", path, PTR_ERR(filp));
-        goto free_buf;
-    }
-
-    // Read the memory usage
-    bytes_read = kernel_read(filp, buf, 127, &pos);
-    if (bytes_read > 0) {
-        buf[bytes_read] = '\0'; // Ensure null termination
-        ret = kstrtoul(buf, 10, &mem_usage); // Convert string to unsigned long
-        if (ret < 0) {
-            printk(KERN_WARNING "Failed to parse memory usage from %s\n", path);
-            mem_usage = 0;
+static void cgroup_file_close(void *file) {
+    filp_close(file, NULL);
+}
+
+static void cgroup_file_error(const char *path, int err) {
+    trace_sysinfo_cgroup_read_error(path, err);
+}
+
+static const struct cgroup_file_ops sysinfo_file_ops = {
+    .open = cgroup_file_open,
+    .read = cgroup_file_read,
+    .close = cgroup_file_close,
+    .error = cgroup_file_error,
+};
+
+static struct stat_field memory_stat_fields[MEMORY_STAT_MAX_FIELDS];
+static int nr_memory_stat_fields;
+
+// Agrega las claves pedidas en memory_stat_keys a la tabla de memory.stat
+static int memory_stat_init(void) {
+    for (int i = 0; i < nr_memory_stat_keys; i++) {
+        const char *key = memory_stat_keys[i];
+
+        // Las claves se escriben tal cual en el JSON
+        if (!*key || key[strspn(key, "abcdefghijklmnopqrstuvwxyz0123456789_")]) {
+            printk(KERN_ERR "sysinfo_202202906: clave de memory.stat inválida '%s'\n", key);
+            return -EINVAL;
         }
-    } else {
-        printk(KERN_WARNING "Failed to read from %s\n", path);
     }
+    nr_memory_stat_fields = memory_stat_fields_init(memory_stat_fields, memory_stat_keys, nr_memory_stat_keys);
+    return 0;
+}
 
-    // Close the file
-    filp_close(filp, NULL);
+static void kernfs_cpu_stat(struct container_entry *e, struct cpu_stat *cs) {
+    get_cpu_stat(&scratch->reader, e->cgroup_dir, cs);
+}
+
+static unsigned long kernfs_memory_kb(struct container_entry *e) {
+    return get_memory_usage(&scratch->reader, e->cgroup_dir);
+}
+
+// usage_usec de cpu.stat sin flush de rstat: suma el tiempo propio del cgroup en cada CPU
+static unsigned long direct_cpu_usage_usec(struct container_entry *e) {
+    struct cgroup *cgrp = e->css->cgroup;
+    u64 sum_exec = 0;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 16, 0)
+        struct cgroup_rstat_base_cpu *rstatc = per_cpu_ptr(cgrp->rstat_base_cpu, cpu);
+#else
+        struct cgroup_rstat_cpu *rstatc = per_cpu_ptr(cgrp->rstat_cpu, cpu);
+#endif
+        unsigned int seq;
+        u64 exec;
+
+        do {
+            seq = u64_stats_fetch_begin(&rstatc->bsync);
+            exec = rstatc->bstat.cputime.sum_exec_runtime;
+        } while (u64_stats_fetch_retry(&rstatc->bsync, seq));
+        sum_exec += exec;
+    }
 
-    free_buf:
-        kfree(buf);
-    free_path:
-        kfree(path);
+    return div_u64(sum_exec, NSEC_PER_USEC);
+}
 
-    // Se convierte en MB
-    return mem_usage / 1024 ;
+// El throttling de CFS vive en el task_group del scheduler, que no es visible para módulos: sale de cpu.stat
+static void direct_cpu_stat(struct container_entry *e, struct cpu_stat *cs) {
+    if (collect_throttling)
+        get_cpu_stat(&scratch->reader, e->cgroup_dir, cs);
+    else
+        memset(cs, 0, sizeof(*cs));
+    cs->usage_usec = direct_cpu_usage_usec(e);
 }
 
-static void get_memory_stats(const char *container_id, unsigned long *anon, unsigned long *k_stack) {
-    char *path = NULL;
-    struct file *filp = NULL;
-    char *buf = NULL;
-    loff_t pos = 0;
-    ssize_t bytes_read;
-    char *line, *value_start, *end;
-    unsigned long current_anon = 0, current_kstack = 0;
-    int ret;
+// memory.current es el page_counter "memory" del memcg
+static unsigned long direct_memory_kb(struct container_entry *e) {
+#ifdef CONFIG_MEMCG
+    struct mem_cgroup *memcg = mem_cgroup_from_css(e->css);
+
+    return page_counter_read(&memcg->memory) * (PAGE_SIZE / 1024);
+#else
+    return kernfs_memory_kb(e);
+#endif
+}
+
+static const struct collect_backend collect_backends[] = {
+    { .name = "direct", .cpu_stat = direct_cpu_stat, .memory_kb = direct_memory_kb },
+    { .name = "kernfs", .cpu_stat = kernfs_cpu_stat, .memory_kb = kernfs_memory_kb },
+};
+
+static const struct collect_backend *backend;
+
+// Arma "<cgroup_root>/<ruta del cgroup>" una sola vez por contenedor
+static char *get_cgroup_dir(struct cgroup *cgrp) {
+    char *buf = scratch->path;
+    int len;
+
+    len = scnprintf(buf, PATH_MAX, "%s", cgroup_root);
+    if (cgroup_path(cgrp, buf + len, PATH_MAX - len) <= 0)
+        return NULL;
+    return kstrdup(buf, GFP_KERNEL);
+}
+
+static struct container_entry *registry_lookup(const char *id, u32 hash) {
+    struct container_entry *e;
+
+    hash_for_each_possible(container_registry, e, node, hash) {
+        if (e->hash == hash && strcmp(e->id, id) == 0)
+            return e;
+    }
+    return NULL;
+}
 
-    *anon = 0;
-    *k_stack = 0;
+// Guarda PID, nombre y cmdline del proceso que representa al contenedor; cmdline NULL la lee del proceso
+static void registry_set_task(struct container_entry *e, struct task_struct *task, const char *cmdline) {
+    e->pid = task->pid;
+    strscpy(e->comm, task->comm, sizeof(e->comm));
+    if (cmdline)
+        strscpy(e->cmdline, cmdline, sizeof(e->cmdline));
+    else if (get_process_cmdline(task, e->cmdline) < 0)
+        strscpy(e->cmdline, "N/A", sizeof(e->cmdline));
+}
 
-    // Allocate memory for the path
-    path = kmalloc(PATH_MAX, GFP_KERNEL);
-    if (!path) {
-        printk(KERN_WARNING "Failed to allocate memory for path\n");
+// Un alta sin proceso "stress" (por cgroup_mkdir o con el cgroup vacío) ya tiene uno que la represente
+static void registry_adopt(struct container_entry *e, struct task_struct *task) {
+    if (!e->ignored)
         return;
+    e->css = task_get_css(task, memory_cgrp_id);
+    e->ignored = false;
+}
+
+static struct container_entry *registry_add(struct task_struct *task, const char *id, u32 hash,
+                                            const char *cmdline) {
+    struct container_entry *e;
+
+    e = kmem_cache_zalloc(entry_cache, GFP_KERNEL);
+    if (!e) {
+        dbg_inc(DBG_ALLOC_FAILURES);
+        return NULL;
     }
 
-    // Allocate memory for the buffer
-    buf = kmalloc(512, GFP_KERNEL); // Larger buffer for memory.stat
-    if (!buf) {
-        printk(KERN_WARNING "Failed to allocate memory for buffer\n");
-        goto free_path;
+    e->hash = hash;
+    e->start_ns = ktime_get_real_ns();
+    strscpy(e->id, id, sizeof(e->id));
+    e->css = task_get_css(task, memory_cgrp_id);
+    e->cgroup_dir = get_cgroup_dir(e->css->cgroup);
+    if (!e->cgroup_dir) {
+        css_put(e->css);
+        kmem_cache_free(entry_cache, e);
+        return NULL;
     }
+    registry_set_task(e, task, cmdline);
 
-    // Construct the path to the memory.stat file
-    snprintf(path, PATH_MAX, "/sys/fs/cgroup/system.slice/docker-%s.scope/memory.stat", container_id);
+    hash_add(container_registry, &e->node, hash);
+    registry_count++;
+    return e;
+}
 
-    // Open the file
-    filp = filp_open(path, O_RDONLY, 0);
-    if (IS_ERR(filp)) {
-        printk(KERN_WARNING "Failed to open %s: %ld\n", path, PTR_ERR(filp));
-        goto free_buf;
-    }
-
-    // Read the entire file content
-    bytes_read = kernel_read(filp, buf, 511, &pos);
-    if (bytes_read > 0) {
-        buf[bytes_read] = '\0';
-
-        // Parse the file
-        line = buf;
-        while (line && *line) {
-            if ((value_start = strstr(line, "kernel ")) != NULL) {
-                value_start += strlen("kernel ");
-                end = value_start;
-                while (*end && *end != ' ' && *end != '\n') end++;
-                if (end > value_start) {
-                    char temp[32];
-                    size_t len = end - value_start;
-                    if (len >= sizeof(temp)) len = sizeof(temp) - 1;
-                    strncpy(temp, value_start, len);
-                    temp[len] = '\0';
-                    ret = kstrtoul(temp, 10, &current_anon);
-                    if (ret < 0) current_anon = 0;
-                }
-            }
-            if ((value_start = strstr(line, "kernel_stack ")) != NULL) {
-                value_start += strlen("kernel_stack ");
-                end = value_start;
-                while (*end && *end != ' ' && *end != '\n') end++;
-                if (end > value_start) {
-                    char temp[32];
-                    size_t len = end - value_start;
-                    if (len >= sizeof(temp)) len = sizeof(temp) - 1;
-                    strncpy(temp, value_start, len);
-                    temp[len] = '\0';
-                    ret = kstrtoul(temp, 10, &current_kstack);
-                    if (ret < 0) current_kstack = 0;
-                    break;
-                }
-            }
-            line = strstr(line, "\n");
-            if (line) line++;
-        }
+/*
+    Alta desde el descubrimiento por cgroups: el proceso representativo
+    (PID, cmdline y css de memoria) se busca solo esta vez, con cgroup.procs
+*/
+static struct container_entry *registry_add_cgroup(struct cgroup *cgrp, const char *id, u32 hash) {
+    struct container_entry *e;
+    struct task_struct *task;
+
+    e = kmem_cache_zalloc(entry_cache, GFP_KERNEL);
+    if (!e) {
+        dbg_inc(DBG_ALLOC_FAILURES);
+        return NULL;
+    }
+
+    e->hash = hash;
+    e->start_ns = ktime_get_real_ns();
+    strscpy(e->id, id, sizeof(e->id));
+    e->cgroup_dir = get_cgroup_dir(cgrp);
+    if (!e->cgroup_dir) {
+        kmem_cache_free(entry_cache, e);
+        return NULL;
+    }
+
+    task = get_representative_task(e->cgroup_dir);
+    if (task && strcmp(task->comm, "stress") == 0) {
+        e->css = task_get_css(task, memory_cgrp_id);
+        registry_set_task(e, task, NULL);
     } else {
-        printk(KERN_WARNING "Failed to read from %s\n", path);
+        e->ignored = true;
     }
+    if (task)
+        put_task_struct(task);
 
-    filp_close(filp, NULL);
+    hash_add(container_registry, &e->node, hash);
+    registry_count++;
+    return e;
+}
 
-    *anon = current_anon / 1024;
-    *k_stack = current_kstack / 1024;
+/*
+    Un alta por cgroups que cayó antes del exec de "stress" (runc init,
+    sh -c "exec stress ..." o cgroup_mkdir) queda ignorada; sin los eventos de
+    lifecycle nadie la adopta, así que durante REPROBE_WINDOW_NS desde el alta
+    cada pasada vuelve a buscar su proceso. Después se da por un contenedor
+    que no es de estrés y no se vuelve a leer su cgroup.procs
+*/
+static bool registry_reprobe(struct container_entry *e) {
+    struct task_struct *task;
 
-    free_buf:
-        kfree(buf);
-    free_path:
-        kfree(path);
+    task = get_representative_task(e->cgroup_dir);
+    if (!task)
+        return false;
+    if (strcmp(task->comm, "stress") == 0) {
+        registry_adopt(e, task);
+        registry_set_task(e, task, NULL);
+    }
+    put_task_struct(task);
+    return !e->ignored;
 }
 
+static void registry_remove(struct container_entry *e) {
+    hash_del(&e->node);
+    registry_count--;
+    if (e->css)
+        css_put(e->css);
+    kfree(e->cgroup_dir);
+    kfree(e->points);
+    kmem_cache_free(entry_cache, e);
+}
 
-static unsigned long get_cpu_usage_container(const char *container_id) {
-    char *path = NULL;
-    struct file *filp = NULL;
-    char *buf = NULL;
-    loff_t pos = 0;
-    ssize_t bytes_read;
-    unsigned long cpu_usage = 0;
-    int ret;
-    char *line, *value_start, *end;
+/*
+    Contenedores terminados: al darse de baja, un contenedor deja su registro
+    con el inicio, el fin y los últimos contadores acumulados en un anillo de
+    exited_max entradas que se lee en /proc/sysinfo_202202906_exited. Así un
+    contenedor que vivió entre dos lecturas del consumidor queda contabilizado.
+    Seq crece con cada baja; el consumidor guarda el último que procesó
+*/
+struct exited_container {
+    u64 seq;
+    char id[CONTAINER_ID_MAX];
+    char comm[TASK_COMM_LEN];
+    char cmdline[MAX_CMDLINE_LENGTH];
+    pid_t pid;
+    bool start_exact;                   // Inicio tomado de cgroup_mkdir
+    bool stop_exact;                    // Fin tomado de sched_process_exit o cgroup_rmdir
+    u64 start_ns;                       // Tiempo real, en ns desde la época
+    u64 stop_ns;
+    u64 nr_samples;
+    unsigned long cpu_usage_usec;
+    unsigned long max_mem_kb;
+    unsigned long read_kb;
+    unsigned long write_kb;
+    unsigned long io_read_ops;
+    unsigned long io_write_ops;
+};
 
-    // Allocate memory for the path
-    path = kmalloc(PATH_MAX, GFP_KERNEL);
-    if (!path) {
-        printk(KERN_WARNING "Failed to allocate memory for path\n");
-        return 0;
-    }
+static struct exited_container *exited_ring;
+static u64 exited_seq;                  // Registros escritos desde la carga, el siguiente lleva este seq
+static DEFINE_MUTEX(exited_lock);
 
-    // Allocate memory for the buffer
-    buf = kmalloc(256, GFP_KERNEL); // Larger buffer to handle multiple lines
-    if (!buf) {
-        printk(KERN_WARNING "Failed to allocate memory for buffer\n");
-        goto free_path;
-    }
+/*
+    Guarda el registro de e; stop_ns es el momento de la baja y exact indica
+    si viene de un evento. Si el proceso principal ya había terminado, el fin
+    es su salida y los contadores son los de la muestra final de ese momento
+*/
+static void exited_record(struct container_entry *e, u64 stop_ns, bool exact) {
+    struct exited_container *x;
 
-    // Construct the path to the cpu.stat file
-    snprintf(path, PATH_MAX, "/sys/fs/cgroup/system.slice/docker-%s.scope/cpu.stat", container_id);
+    if (!exited_max || e->ignored)
+        return;
 
-    // Open the file
-    filp = filp_open(path, O_RDONLY, 0);
-    if (IS_ERR(filp)) {
-        printk(KERN_WARNING "Failed to open %s: %ld\n", path, PTR_ERR(filp));
-        goto free_buf;
-    }
-
-    // Read the entire file content
-    bytes_read = kernel_read(filp, buf, 255, &pos);
-    if (bytes_read > 0) {
-        buf[bytes_read] = '\0'; // Ensure null termination
-
-        // Parse the file line by line
-        line = buf;
-        while ((line = strstr(line, "usage_usec")) != NULL) {
-            printk(KERN_INFO "Found 'usage_usec' at line: %s\n", line); // Debug print
-            value_start = line + strlen("usage_usec"); // Move past "usage_usec"
-            while (*value_start == ' ' || *value_start == '\t') value_start++; // Skip whitespace
-            if (*value_start == '\0' || *value_start == '\n') break; // Invalid line
-
-            // Find the end of the number (next whitespace or newline)
-            end = value_start;
-            while (*end && *end != ' ' && *end != '\t' && *end != '\n') end++;
-            if (end > value_start) {
-                char temp[32]; // Temporary buffer for the number
-                size_t len = end - value_start;
-                if (len >= sizeof(temp)) len = sizeof(temp) - 1;
-                strncpy(temp, value_start, len);
-                temp[len] = '\0';
-                ret = kstrtoul(temp, 10, &cpu_usage);
-                if (ret == 0) {
-                    printk(KERN_INFO "Parsed usage_usec: %lu\n", cpu_usage); // Debug print
-                    break; // Successfully parsed
-                }
-            }
-            line = end; // Move to next line or position
-        }
+    mutex_lock(&exited_lock);
+    x = &exited_ring[exited_seq % exited_max];
+    x->seq = exited_seq++;
+    strscpy(x->id, e->id, sizeof(x->id));
+    strscpy(x->comm, e->comm, sizeof(x->comm));
+    strscpy(x->cmdline, e->cmdline, sizeof(x->cmdline));
+    x->pid = e->pid;
+    x->start_exact = e->tracked;
+    x->stop_exact = e->exit_ns || exact;
+    x->start_ns = e->start_ns;
+    x->stop_ns = e->exit_ns ?: stop_ns;
+    x->nr_samples = e->nr_samples;
+    x->cpu_usage_usec = e->last_cpu_usage_usec;
+    x->max_mem_kb = e->max_mem_kb;
+    x->read_kb = e->last_read_kb;
+    x->write_kb = e->last_write_kb;
+    x->io_read_ops = e->last_io_read_ops;
+    x->io_write_ops = e->last_io_write_ops;
+    mutex_unlock(&exited_lock);
+}
 
-        if (ret < 0) {
-            printk(KERN_WARNING "Failed to parse cpu usage from %s\n", path);
-            cpu_usage = 0;
+/*
+    Se pone en true cuando se pierde un evento de alta o baja (cola llena o
+    sin memoria). El siguiente barrido deja de confiar en cgroup_rmdir para
+    los contenedores seguidos y los da de baja como antes de los eventos
+*/
+static bool lifecycle_lost;
+static unsigned int lifecycle_removed;  // Bajas por cgroup_rmdir desde la pasada anterior
+
+/*
+    Elimina los contenedores que no aparecieron en la pasada gen (o todos si
+    gen es 0). Los seguidos por eventos se quedan hasta su cgroup_rmdir
+*/
+static unsigned int registry_sweep(u64 gen) {
+    struct container_entry *e;
+    struct hlist_node *tmp;
+    unsigned int removed = lifecycle_removed;
+    bool untrack = xchg(&lifecycle_lost, false);
+    int bkt;
+
+    lifecycle_removed = 0;
+    hash_for_each_safe(container_registry, bkt, tmp, e, node) {
+        if (untrack)
+            e->tracked = false;
+        if (!gen || (e->seen_gen != gen && !e->tracked)) {
+            if (!e->ignored)
+                removed++;
+            if (gen)
+                exited_record(e, ktime_get_real_ns(), false);
+            registry_remove(e);
         }
-    } else {
-        printk(KERN_WARNING "Failed to read from %s\n", path);
     }
+    return removed;
+}
 
-    // Close the file
-    filp_close(filp, NULL);
+/*
+    Estadísticas por ventana: cada contenedor guarda sus últimas
+    stats_ring_size muestras y en cada pasada se calculan min/max/media/p95
+    de las ventanas de stats_windows. Las ventanas están ordenadas y anidadas,
+    así un solo recorrido del anillo (de la muestra más nueva a la más vieja)
+    las cierra todas: cada vez que se cruza el límite de una ventana se
+    resume lo acumulado hasta ese punto
+*/
+static unsigned int stats_hist_bucket(u32 v) {
+    unsigned int shift;
+
+    if (v < (1U << STATS_HIST_SUB_BITS))
+        return v;
+    shift = fls(v) - 1 - STATS_HIST_SUB_BITS;
+    return ((shift + 1) << STATS_HIST_SUB_BITS) + ((v >> shift) & ((1U << STATS_HIST_SUB_BITS) - 1));
+}
 
-    free_buf:
-        kfree(buf);
-    free_path:
-        kfree(path);
+// Punto medio de la cubeta
+static u32 stats_hist_value(unsigned int b) {
+    unsigned int shift;
 
-    return cpu_usage; // Returns usage in microseconds
+    if (b < (1U << STATS_HIST_SUB_BITS))
+        return b;
+    shift = (b >> STATS_HIST_SUB_BITS) - 1;
+    return (((1U << STATS_HIST_SUB_BITS) | (b & ((1U << STATS_HIST_SUB_BITS) - 1))) << shift) +
+           ((1U << shift) >> 1);
 }
 
-static void get_io_stats(const char *container_id, unsigned long *read_mb, unsigned long *write_mb, 
-    unsigned long *io_read_ops, unsigned long *io_write_ops) {
-    char *path = NULL;
-    struct file *filp = NULL;
-    char *buf = NULL;
-    loff_t pos = 0;
-    ssize_t bytes_read;
-    char *line, *value_start, *end;
-    unsigned long current_rbytes = 0, current_wbytes = 0, current_readops = 0, current_writeops = 0;
-    int ret;
+static void stats_record(struct container_entry *e, u64 now, u32 cpu, u32 mem, u32 iops) {
+    struct stat_point *p;
+
+    if (!e->points) {
+        e->points = kcalloc(stats_ring_size, sizeof(*e->points), GFP_KERNEL);
+        if (!e->points) {
+            dbg_inc(DBG_ALLOC_FAILURES);
+            return;
+        }
+    }
 
-    *read_mb = 0;
-    *write_mb = 0;
+    p = &e->points[e->points_head];
+    p->timestamp_ns = now;
+    p->value[STAT_CPU] = cpu;
+    p->value[STAT_MEM] = mem;
+    p->value[STAT_IOPS] = iops;
+    e->points_head = (e->points_head + 1) % stats_ring_size;
+    if (e->nr_points < stats_ring_size)
+        e->nr_points++;
+}
 
-    // Allocate memory for the path
-    path = kmalloc(PATH_MAX, GFP_KERNEL);
-    if (!path) {
-        printk(KERN_WARNING "Failed to allocate memory for path\n");
+static void stats_finish(struct window_stats *ws, const struct metric_stats *run, const u64 *sum, u32 n) {
+    ws->samples = n;
+    if (!n)
         return;
+
+    for (int i = 0; i < NR_STAT_METRICS; i++) {
+        u32 rank = n - n * 5 / 100, seen = 0;
+        unsigned int b;
+
+        ws->m[i].min = run[i].min;
+        ws->m[i].max = run[i].max;
+        ws->m[i].mean = div_u64(sum[i], n);
+        for (b = 0; b < STATS_HIST_BUCKETS - 1; b++) {
+            seen += stats_hist[i][b];
+            if (seen >= rank)
+                break;
+        }
+        ws->m[i].p95 = clamp(stats_hist_value(b), run[i].min, run[i].max);
     }
+}
 
-    // Allocate memory for the buffer
-    buf = kmalloc(512, GFP_KERNEL); // Larger buffer for io.stat
-    if (!buf) {
-        printk(KERN_WARNING "Failed to allocate memory for buffer\n");
-        goto free_path;
+static void stats_compute(struct container_entry *e, struct container_sample *sample, u64 now) {
+    struct metric_stats run[NR_STAT_METRICS];
+    u64 sum[NR_STAT_METRICS] = {};
+    unsigned int w = 0;
+    u32 n = 0;
+
+    memset(stats_hist, 0, sizeof(stats_hist));
+    for (int i = 0; i < NR_STAT_METRICS; i++) {
+        run[i].min = U32_MAX;
+        run[i].max = 0;
     }
 
-    // Construct the path to the io.stat file
-    snprintf(path, PATH_MAX, "/sys/fs/cgroup/system.slice/docker-%s.scope/io.stat", container_id);
+    for (unsigned int i = 0; i < e->nr_points; i++) {
+        const struct stat_point *p = &e->points[(e->points_head + stats_ring_size - 1 - i) % stats_ring_size];
 
-    // Open the file
-    filp = filp_open(path, O_RDONLY, 0);
-    if (IS_ERR(filp)) {
-        printk(KERN_WARNING "Failed to open %s: %ld\n", path, PTR_ERR(filp));
-        goto free_buf;
-    }
-
-    // Read the entire file content
-    bytes_read = kernel_read(filp, buf, 511, &pos);
-    if (bytes_read > 0) {
-        buf[bytes_read] = '\0';
-
-        // Parse the file for rbytes and wbytes
-        line = buf;
-        while (line && *line) {
-            if ((value_start = strstr(line, "rbytes=")) != NULL) {
-                value_start += strlen("rbytes=");
-                end = value_start;
-                while (*end && *end != ' ' && *end != '\n') end++;
-                if (end > value_start) {
-                    char temp[32];
-                    size_t len = end - value_start;
-                    if (len >= sizeof(temp)) len = sizeof(temp) - 1;
-                    strncpy(temp, value_start, len);
-                    temp[len] = '\0';
-                    ret = kstrtoul(temp, 10, &current_rbytes);
-                    if (ret < 0) current_rbytes = 0;
-                }
-            }
-            if ((value_start = strstr(line, "wbytes=")) != NULL) {
-                value_start += strlen("wbytes=");
-                end = value_start;
-                while (*end && *end != ' ' && *end != '\n') end++;
-                if (end > value_start) {
-                    char temp[32];
-                    size_t len = end - value_start;
-                    if (len >= sizeof(temp)) len = sizeof(temp) - 1;
-                    strncpy(temp, value_start, len);
-                    temp[len] = '\0';
-                    ret = kstrtoul(temp, 10, &current_wbytes);
-                    if (ret < 0) current_wbytes = 0;
-                }
-            }
-            if ((value_start = strstr(line, "rios=")) != NULL) {
-                value_start += strlen("rios=");
-                end = value_start;
-                while (*end && *end != ' ' && *end != '\n') end++;
-                if (end > value_start) {
-                    char temp[32];
-                    size_t len = end - value_start;
-                    if (len >= sizeof(temp)) len = sizeof(temp) - 1;
-                    strncpy(temp, value_start, len);
-                    temp[len] = '\0';
-                    ret = kstrtoul(temp, 10, &current_readops);
-                    if (ret < 0) current_readops = 0;
-                }
-            }
-            if ((value_start = strstr(line, "wios=")) != NULL) {
-                value_start += strlen("wios=");
-                end = value_start;
-                while (*end && *end != ' ' && *end != '\n') end++;
-                if (end > value_start) {
-                    char temp[32];
-                    size_t len = end - value_start;
-                    if (len >= sizeof(temp)) len = sizeof(temp) - 1;
-                    strncpy(temp, value_start, len);
-                    temp[len] = '\0';
-                    ret = kstrtoul(temp, 10, &current_writeops);
-                    if (ret < 0) current_writeops = 0;
-                }
-            }
-            line = strstr(line, "\n");
-            if (line) line++;
+        while (w < nr_stats_windows && now - p->timestamp_ns > (u64)stats_windows[w] * NSEC_PER_SEC)
+            stats_finish(&sample->stats[w++], run, sum, n);
+        if (w == nr_stats_windows)
+            return;
+
+        n++;
+        for (int m = 0; m < NR_STAT_METRICS; m++) {
+            u32 v = p->value[m];
+
+            sum[m] += v;
+            run[m].min = min(run[m].min, v);
+            run[m].max = max(run[m].max, v);
+            stats_hist[m][stats_hist_bucket(v)]++;
         }
-    } else {
-        printk(KERN_WARNING "Failed to read from %s\n", path);
     }
 
-    filp_close(filp, NULL);
+    // Si el anillo es más corto que la ventana, la ventana cubre lo que hay
+    while (w < nr_stats_windows)
+        stats_finish(&sample->stats[w++], run, sum, n);
+}
 
-    *read_mb = current_rbytes / 1024;
-    *write_mb = current_wbytes / 1024;
-    *io_read_ops = current_readops;
-    *io_write_ops = current_writeops;
+static int stats_cmp_window(const void *a, const void *b) {
+    unsigned int x = *(const unsigned int *)a, y = *(const unsigned int *)b;
 
-    free_buf:
-        kfree(buf);
-    free_path:
-        kfree(path);
+    return x < y ? -1 : x > y;
 }
 
-static int sysinfo_show(struct seq_file *m, void *v) {
-    struct sysinfo si;
-    struct task_struct *task;
-    int first_process = 1;
-    unsigned long cpu_usage_total;
-    char *seen_containers[150] = {0}; // Simple array to track seen container IDs
-    int container_count = 0;
+// Deja stats_windows ordenado y sin ceros; sin ventanas o sin anillo no se calculan estadísticas
+static void stats_init(void) {
+    int n = 0;
 
-    si_meminfo(&si);
-    cpu_usage_total = get_cpu_usage();
+    for (int i = 0; i < nr_stats_windows; i++) {
+        if (stats_windows[i])
+            stats_windows[n++] = stats_windows[i];
+    }
+    nr_stats_windows = stats_ring_size ? n : 0;
+    sort(stats_windows, nr_stats_windows, sizeof(stats_windows[0]), stats_cmp_window, NULL);
+}
 
-    seq_printf(m, "{\n");
-    seq_printf(m, "  \"Memory\": {\n");
-    seq_printf(m, "    \"Total_Memory_MB\": %lu,\n", si.totalram * 4 / 1024);
-    seq_printf(m, "    \"Free_Memory_MB\": %lu,\n", si.freeram * 4 / 1024);
-    seq_printf(m, "    \"Used_Memory_MB\": %lu,\n", (si.totalram - si.freeram) * 4 / 1024);
-    seq_printf(m, "    \"CPU_Usage_Percentage\": %lu.%02lu\n", cpu_usage_total / 100, cpu_usage_total % 100);
-    seq_printf(m, "  },\n");
+/*
+    Lee los contadores de un contenedor y calcula los deltas contra la muestra
+    anterior. Devuelve los eventos de poll() que genera: alta del contenedor o
+    cruce de los umbrales de CPU o memoria
+*/
+static unsigned int sysinfo_collect_container(struct container_entry *e, struct container_sample *sample,
+                                              unsigned long total_memory_mb) {
+    struct sysinfo_collect_opts opts = {
+        .pressure = collect_pressure,
+        .nr_memory_stat_keys = nr_memory_stat_keys,
+        .memory_stat_fields = memory_stat_fields,
+        .nr_memory_stat_fields = nr_memory_stat_fields,
+    };
+    struct cpu_stat cs;
+    unsigned int events = 0;
+    bool over;
+    u64 now;
+
+    if (!e->last_sample_ns)
+        events |= SYSINFO_EV_ADDED;
+
+    strscpy(sample->id, e->id, sizeof(sample->id));
+    strscpy(sample->comm, e->comm, sizeof(sample->comm));
+    strscpy(sample->cmdline, e->cmdline, sizeof(sample->cmdline));
+    sample->pid = e->pid;
+
+    // El uso de CPU se calcula con el delta de usage_usec contra la muestra anterior
+    backend->cpu_stat(e, &cs);
+    sysinfo_sample_cpu_stat(sample, &cs);
+    now = ktime_get_ns();
+    if (e->last_sample_ns && now > e->last_sample_ns && sample->cpu_usage_usec >= e->last_cpu_usage_usec)
+        sample->cpu_percentage = div64_u64((u64)(sample->cpu_usage_usec - e->last_cpu_usage_usec) * 10000,
+                                           div_u64(now - e->last_sample_ns, NSEC_PER_USEC) ?: 1);
+
+    // memory.stat, *.pressure e io.stat salen de cgroupfs con cualquier backend
+    sysinfo_collect_files(&scratch->reader, e->cgroup_dir, sample, backend->memory_kb(e), &opts);
+    sample->mem_percentage = ((sample->mem_usage_kb / 1024) * 10000) / total_memory_mb;
+
+    // La primera muestra no tiene CPU ni IOPS (no hay delta), no entra a las estadísticas
+    if (nr_stats_windows) {
+        if (e->last_sample_ns && now > e->last_sample_ns) {
+            u64 ops = sample->io_read_ops + sample->io_write_ops;
+            u64 last_ops = e->last_io_read_ops + e->last_io_write_ops;
+            u32 iops = 0;
+
+            if (ops >= last_ops)
+                iops = min_t(u64, div64_u64((ops - last_ops) * NSEC_PER_SEC, now - e->last_sample_ns), U32_MAX);
+            stats_record(e, now, min_t(unsigned long, sample->cpu_percentage, U32_MAX),
+                         min_t(unsigned long, sample->mem_usage_kb, U32_MAX), iops);
+        }
+        stats_compute(e, sample, now);
+    }
 
-    seq_printf(m, "  \"Docker_Containers\": [\n");
+    e->last_sample_ns = now;
+    e->last_cpu_usage_usec = sample->cpu_usage_usec;
+    e->last_mem_kb = sample->mem_usage_kb;
+    e->last_read_kb = sample->read_kb;
+    e->last_write_kb = sample->write_kb;
+    e->last_io_read_ops = sample->io_read_ops;
+    e->last_io_write_ops = sample->io_write_ops;
+    e->max_mem_kb = max(e->max_mem_kb, sample->mem_usage_kb);
+    e->nr_samples++;
+
+    over = poll_cpu_threshold && sample->cpu_percentage >= poll_cpu_threshold;
+    if (over != e->over_cpu)
+        events |= SYSINFO_EV_THRESHOLD;
+    e->over_cpu = over;
+
+    over = poll_mem_threshold && sample->mem_percentage >= poll_mem_threshold;
+    if (over != e->over_mem)
+        events |= SYSINFO_EV_THRESHOLD;
+    e->over_mem = over;
+
+    return events;
+}
 
-    for_each_process(task) {
-        if (strcmp(task->comm, "stress") == 0 && is_parent_process(task)) { // Check if it's a parent process
-            char *containerID = get_container_id(task);
-            char *cmdline = NULL;
-            int already_seen = 0;
-
-            // Skip if container ID is already processed
-            if (containerID) {
-                for (int i = 0; i < container_count; i++) {
-                    if (seen_containers[i] && strcmp(seen_containers[i], containerID) == 0) {
-                        already_seen = 1;
-                        break;
-                    }
-                }
-            }
+static struct sysinfo_snapshot *snapshot_alloc(unsigned int count);
 
-            if (!already_seen && containerID) {
-                unsigned long mem_usage = 0, mem_percentage = 0;
-                unsigned long disk_read_mb = 0, disk_write_mb = 0;
-
-                unsigned long anon, kernel_stack;
-                get_memory_stats(containerID, &anon, &kernel_stack);
-
-                unsigned long cpu_usage_1 = get_cpu_usage_container(containerID);
-                unsigned long total_system_1 = get_jiffies_64();
-                msleep(100);
-                unsigned long cpu_usage_2 = get_cpu_usage_container(containerID);
-                unsigned long total_system_2 = get_jiffies_64();
-                unsigned long cpu_percentage = ((cpu_usage_2 - cpu_usage_1) / (total_system_2-total_system_1));
-
-                cmdline = get_process_cmdline(task);
-
-                unsigned long total_memory_mb = si.totalram * 4 / 1024; // Total RAM in MB
-                mem_usage = get_memory_usage(containerID);
-
-                if (cmdline && strstr(cmdline, "--hdd")) {
-                    mem_usage = anon + kernel_stack;
-                    mem_percentage = ( (mem_usage / 1024) * 10000) / total_memory_mb;
-                } else {
-                    mem_percentage = ( (mem_usage / 1024) * 10000) / total_memory_mb;
-                }
-
-                unsigned long read_mb, write_mb, io_read_ops, io_write_ops;
-                get_io_stats(containerID, &read_mb, &write_mb, &io_read_ops, &io_write_ops);
-
-                // Calcular MemoryUsage_MB con decimales
-                unsigned long mem_usage_mb_whole = mem_usage / 1024; // Parte entera (MB)
-                unsigned long mem_usage_mb_frac = ((mem_usage % 1024) * 100) / 1024; // Parte fraccional (2 dígitos)
-
-                // Calcular DiskUse_MB con decimales
-                unsigned long disk_usage_kb = write_mb + read_mb; // Total en KB
-                unsigned long disk_usage_mb_whole = disk_usage_kb / 1024; // Parte entera (MB)
-                unsigned long disk_usage_mb_frac = ((disk_usage_kb % 1024) * 100) / 1024; // Parte fraccional (2 dígitos)
-
-                if (!first_process) {
-                    seq_printf(m, ",\n");
-                } else {
-                    first_process = 0;
-                }
-
-                seq_printf(m, "    {\n");
-                seq_printf(m, "      \"PID\": %d,\n", task->pid);
-                seq_printf(m, "      \"Name\": \"%s\",\n", task->comm);
-                seq_printf(m, "      \"ContainerID\": \"%.12s\",\n", containerID ? containerID : "N/A");
-                seq_printf(m, "      \"Cmdline\": \"%s\",\n", cmdline ? cmdline : "N/A");
-                seq_printf(m, "      \"MemoryUsage_percent\": %lu.%02lu,\n", mem_percentage / 100, mem_percentage % 100);
-                seq_printf(m, "      \"MemoryUsage_MB\": %lu.%02lu,\n", mem_usage_mb_whole, mem_usage_mb_frac);
-                seq_printf(m, "      \"CPUUsage_percent\": %lu.%02lu,\n", cpu_percentage / 10, cpu_percentage % 10);
-                seq_printf(m, "      \"DiskUse_MB\": %lu.%02lu,\n", disk_usage_mb_whole, disk_usage_mb_frac);
-                seq_printf(m, "      \"Write_KBytes\": %lu,\n", write_mb);
-                seq_printf(m, "      \"Read_KBytes\": %lu,\n", read_mb);
-                seq_printf(m, "      \"IOReadOps\": %lu,\n", io_read_ops);
-                seq_printf(m, "      \"IOWriteOps\": %lu\n", io_write_ops);
-                
-                seq_printf(m, "    }");
-
-                // Store the container ID to avoid duplicates
-                if (container_count < 128) {
-                    seen_containers[container_count++] = containerID;
-                } else {
-                    kfree(containerID); // Free if we exceed the array size
-                }
-            } else {
-                if (containerID) kfree(containerID);
-            }
+static struct task_cache_entry *task_cache_lookup(pid_t pid, u64 start_time) {
+    struct task_cache_entry *tc;
+
+    hash_for_each_possible(task_cache, tc, node, pid) {
+        if (tc->pid == pid && tc->start_time == start_time)
+            return tc;
+    }
+    return NULL;
+}
+
+// Devuelve la entrada del proceso; solo la primera vez se lee el cgroup y la memoria del proceso
+static struct task_cache_entry *task_cache_get(struct task_struct *task, u64 gen) {
+    struct task_cache_entry *tc;
+
+    tc = task_cache_lookup(task->pid, task->start_time);
+    if (!tc) {
+        tc = kmem_cache_zalloc(task_cache_cachep, GFP_KERNEL);
+        if (!tc) {
+            dbg_inc(DBG_ALLOC_FAILURES);
+            return NULL;
+        }
+
+        tc->pid = task->pid;
+        tc->start_time = task->start_time;
+        tc->is_container = get_container_id(task, tc->id);
+        if (tc->is_container) {
+            tc->hash = jhash(tc->id, strlen(tc->id), 0);
+            if (get_process_cmdline(task, tc->cmdline) < 0)
+                strscpy(tc->cmdline, "N/A", sizeof(tc->cmdline));
+        }
+
+        spin_lock(&task_cache_lock);
+        hash_add(task_cache, &tc->node, tc->pid);
+        spin_unlock(&task_cache_lock);
+    }
+
+    tc->seen_gen = gen;
+    return tc;
+}
+
+/*
+    Libera las entradas de procesos que terminaron o que no aparecieron en la
+    pasada gen (todas si gen es 0). En el descubrimiento por cgroups la caché
+    solo tiene los procesos de sched_process_exec y duran hasta que terminan
+*/
+static void task_cache_sweep(u64 gen) {
+    struct task_cache_entry *tc;
+    struct hlist_node *tmp;
+    int bkt;
+
+    hash_for_each_safe(task_cache, bkt, tmp, tc, node) {
+        if (gen && (tc->seen_gen == gen || discover_cgroups) && !READ_ONCE(tc->exited))
+            continue;
+
+        spin_lock(&task_cache_lock);
+        hash_del(&tc->node);
+        spin_unlock(&task_cache_lock);
+        kmem_cache_free(task_cache_cachep, tc);
+    }
+}
 
-            if (cmdline) {
-                kfree(cmdline);
+/*
+    Descubrimiento clásico: recorre los procesos bajo rcu_read_lock y solo toma
+    referencia a los candidatos (procesos "stress" padres) en scratch->tasks.
+    Si no caben, se agranda el arreglo y se recorre otra vez, así ningún
+    contenedor queda fuera de la pasada; solo pasa cuando aumenta la cantidad
+    de procesos
+*/
+static unsigned int collect_stress_tasks(void) {
+    struct task_struct **tasks, *task;
+    unsigned int n, max;
+
+    for (;;) {
+        n = 0;
+        max = scratch->max_tasks;
+
+        rcu_read_lock();
+        for_each_process(task) {
+            if (strcmp(task->comm, "stress") != 0 || !is_parent_process(task)) // Check if it's a parent process
+                continue;
+            if (n < max) {
+                get_task_struct(task);
+                scratch->tasks[n] = task;
             }
+            n++;
         }
+        rcu_read_unlock();
+
+        if (n <= max)
+            return n;
+
+        tasks = kvmalloc_array(n + n / 4 + 8, sizeof(*tasks), GFP_KERNEL);
+        if (!tasks) {
+            dbg_inc(DBG_ALLOC_FAILURES);
+            dbg_add(DBG_CONTAINERS_SKIPPED, n - max);
+            return max;
+        }
+        for (unsigned int i = 0; i < max; i++)
+            put_task_struct(scratch->tasks[i]);
+        kvfree(scratch->tasks);
+        scratch->tasks = tasks;
+        scratch->max_tasks = n + n / 4 + 8;
     }
+}
+
+// Fuera de RCU: la caché, el alta en el registro y la lectura de la cmdline pueden dormir
+static bool discover_task(struct task_struct *task, u64 gen) {
+    struct task_cache_entry *tc;
+    struct container_entry *e;
+
+    tc = task_cache_get(task, gen);
+    if (!tc || !tc->is_container)
+        return false;
+
+    e = registry_lookup(tc->id, tc->hash);
+    if (!e)
+        e = registry_add(task, tc->id, tc->hash, tc->cmdline);
+    if (!e)
+        return false;
+
+    registry_adopt(e, task);
 
-    seq_printf(m, "\n  ]\n");
-    seq_printf(m, "}\n");
+    // Otro proceso padre del mismo contenedor ya fue contado en esta pasada
+    if (e->seen_gen == gen)
+        return false;
 
-    // Clean up seen_containers
-    for (int i = 0; i < container_count; i++) {
-        if (seen_containers[i]) kfree(seen_containers[i]);
+    if (e->pid != task->pid)
+        registry_set_task(e, task, tc->cmdline);
+    e->seen_gen = gen;
+    return true;
+}
+
+static unsigned int discover_by_tasks(u64 gen) {
+    unsigned int seen = 0, nr;
+
+    nr = collect_stress_tasks();
+    for (unsigned int i = 0; i < nr; i++) {
+        if (discover_task(scratch->tasks[i], gen))
+            seen++;
+        put_task_struct(scratch->tasks[i]);
     }
 
-    return 0;
+    task_cache_sweep(gen);
+    return seen;
 }
 
+/*
+    Descubrimiento por cgroups: recorre los css descendientes de docker_parent,
+    así el costo depende de la cantidad de cgroups y no de procesos. Bajo RCU
+    solo se marcan los contenedores conocidos y se toma referencia a los nuevos
+    (hasta DISCOVERY_BATCH por pasada); el alta, que puede dormir, va después
+*/
+static unsigned int discover_by_cgroups(u64 gen) {
+    struct pending_cgroup *pending = scratch->pending;
+    struct cgroup_subsys_state *pos;
+    struct container_entry *e;
+    struct cgroup *parent;
+    unsigned int seen = 0;
+    int npending = 0, bkt;
+    char *path = scratch->path;
+    u64 now;
+
+    parent = cgroup_get_from_path(docker_parent);
+    if (IS_ERR(parent)) {
+        pr_warn_once("sysinfo_202202906: no se encontró el cgroup %s\n", docker_parent);
+        return 0;
+    }
 
-// Función que se ejecuta al abrir el archivo /proc
-static int sysinfo_open(struct inode *inode, struct file *file) {
-    return single_open(file, sysinfo_show, NULL);
+    rcu_read_lock();
+    css_for_each_descendant_pre(pos, &parent->self) {
+        char *id;
+        u32 hash;
+
+        if (pos == &parent->self || cgroup_path(pos->cgroup, path, PATH_MAX) <= 0)
+            continue;
+        id = container_id_from_path(strrchr(path, '/') ?: path);
+        if (!id)
+            continue;
+
+        hash = jhash(id, strlen(id), 0);
+        e = registry_lookup(id, hash);
+        if (e) {
+            e->seen_gen = gen;
+            if (!e->ignored && !e->exit_ns)
+                seen++;
+        } else if (npending == DISCOVERY_BATCH) {
+            // Se da de alta en la siguiente pasada
+            dbg_inc(DBG_CONTAINERS_SKIPPED);
+        } else if (css_tryget_online(pos)) {
+            pending[npending].cgrp = pos->cgroup;
+            strscpy(pending[npending].id, id, CONTAINER_ID_MAX);
+            npending++;
+        }
+    }
+    rcu_read_unlock();
+
+    // Leer cgroup.procs puede dormir, por eso los ignorados se prueban fuera de RCU
+    now = ktime_get_real_ns();
+    hash_for_each(container_registry, bkt, e, node) {
+        if (e->seen_gen != gen || !e->ignored || e->exit_ns || now - e->start_ns > REPROBE_WINDOW_NS)
+            continue;
+        if (registry_reprobe(e))
+            seen++;
+    }
+
+    for (int i = 0; i < npending; i++) {
+        const char *id = pending[i].id;
+
+        e = registry_add_cgroup(pending[i].cgrp, id, jhash(id, strlen(id), 0));
+        cgroup_put(pending[i].cgrp);
+        if (!e)
+            continue;
+        e->seen_gen = gen;
+        if (!e->ignored)
+            seen++;
+    }
+
+    cgroup_put(parent);
+    task_cache_sweep(gen);
+    return seen;
 }
 
-// Estructura de operaciones del archivo /proc
-static const struct proc_ops sysinfo_ops = {
-    .proc_open = sysinfo_open,
-    .proc_read = seq_read,
+/*
+    Seguimiento por eventos del alta y la baja de contenedores. Los probes de
+    cgroup_mkdir/rmdir y sched_process_exec/exit corren sin poder dormir
+    (cgroup_mkdir incluso con las interrupciones apagadas), así que solo
+    encolan el evento y despiertan a lifecycle_work, que corre en la misma
+    workqueue ordenada que el sampler y modifica el registro sin lock:
+      - cgroup_mkdir da de alta el contenedor con su hora de inicio exacta
+      - sched_process_exec de "stress" le asigna su proceso principal
+      - sched_process_exit del proceso principal toma la muestra final,
+        mientras el cgroup sigue en cgroupfs
+      - cgroup_rmdir lo da de baja y deja su registro en exited_ring
+    Así un contenedor que vive menos que sample_period_ms también queda
+    contabilizado. El recorrido de cada pasada sigue corriendo, para los
+    contenedores que existían al cargar el módulo y por si se pierde un evento
+*/
+enum {
+    LIFECYCLE_MKDIR,
+    LIFECYCLE_RMDIR,
+    LIFECYCLE_EXEC,
+    LIFECYCLE_EXIT,
 };
 
-// Inicialización del módulo
-static int __init sysinfo_init(void) {
-    proc_create(PROC_NAME, 0, NULL, &sysinfo_ops);
-    printk(KERN_INFO "sysinfo_202202906: Módulo cargado\n");
-    return 0;
+static const char *const lifecycle_names[] = {
+    [LIFECYCLE_MKDIR] = "mkdir",
+    [LIFECYCLE_RMDIR] = "rmdir",
+    [LIFECYCLE_EXEC] = "exec",
+    [LIFECYCLE_EXIT] = "exit",
+};
+
+struct lifecycle_event {
+    struct list_head node;
+    unsigned int type;
+    u64 timestamp_ns;                   // Tiempo real del evento
+    struct cgroup *cgrp;                // mkdir, con referencia
+    struct task_struct *task;           // exec, con referencia
+    pid_t pid;
+    u64 start_time;                     // exit, junto con pid identifica la entrada de la caché
+    char id[CONTAINER_ID_MAX];          // mkdir, rmdir y exit si el proceso ya estaba en la caché
+};
+
+static LIST_HEAD(lifecycle_queue);
+static unsigned int lifecycle_pending;
+static DEFINE_SPINLOCK(lifecycle_lock);
+static struct work_struct lifecycle_work;
+static struct cgroup_root *lifecycle_root;  // Jerarquía de cgroup v2; los eventos de v1 se ignoran
+static bool lifecycle_active;
+
+static void lifecycle_event_free(struct lifecycle_event *ev) {
+    if (ev->cgrp)
+        cgroup_put(ev->cgrp);
+    if (ev->task)
+        put_task_struct(ev->task);
+    kfree(ev);
+}
+
+static void lifecycle_drop(void) {
+    dbg_inc(DBG_LIFECYCLE_DROPPED);
+    WRITE_ONCE(lifecycle_lost, true);
+}
+
+static struct lifecycle_event *lifecycle_event_alloc(unsigned int type) {
+    struct lifecycle_event *ev;
+
+    ev = kzalloc(sizeof(*ev), GFP_ATOMIC);
+    if (!ev) {
+        lifecycle_drop();
+        return NULL;
+    }
+    ev->type = type;
+    ev->timestamp_ns = ktime_get_real_ns();
+    return ev;
+}
+
+// Con la cola llena el evento se descarta y el barrido vuelve a dar las bajas
+static void lifecycle_queue_event(struct lifecycle_event *ev) {
+    unsigned long flags;
+    bool queued;
+
+    spin_lock_irqsave(&lifecycle_lock, flags);
+    queued = lifecycle_pending < LIFECYCLE_MAX_PENDING;
+    if (queued) {
+        list_add_tail(&ev->node, &lifecycle_queue);
+        lifecycle_pending++;
+    }
+    spin_unlock_irqrestore(&lifecycle_lock, flags);
+
+    if (!queued) {
+        lifecycle_drop();
+        lifecycle_event_free(ev);
+        return;
+    }
+    dbg_inc(DBG_LIFECYCLE_EVENTS);
+    queue_work(sampler_wq, &lifecycle_work);
+}
+
+// Copia en id el ID de un cgroup ".../docker-<id>.scope"; false si no es de un contenedor
+static bool lifecycle_cgroup_id(const char *path, char *id) {
+    char name[CONTAINER_ID_MAX + sizeof("docker-.scope")];
+    const char *base = strrchr(path, '/');
+    char *cid;
+
+    strscpy(name, base ? base + 1 : path, sizeof(name));
+    cid = container_id_from_path(name);
+    if (!cid)
+        return false;
+    strscpy(id, cid, CONTAINER_ID_MAX);
+    return true;
+}
+
+static void probe_cgroup_mkdir(void *data, struct cgroup *cgrp, const char *path) {
+    struct lifecycle_event *ev;
+    char id[CONTAINER_ID_MAX];
+
+    if (cgrp->root != lifecycle_root || !lifecycle_cgroup_id(path, id))
+        return;
+    ev = lifecycle_event_alloc(LIFECYCLE_MKDIR);
+    if (!ev)
+        return;
+    cgroup_get(cgrp);
+    ev->cgrp = cgrp;
+    strscpy(ev->id, id, sizeof(ev->id));
+    lifecycle_queue_event(ev);
+}
+
+static void probe_cgroup_rmdir(void *data, struct cgroup *cgrp, const char *path) {
+    struct lifecycle_event *ev;
+    char id[CONTAINER_ID_MAX];
+
+    if (cgrp->root != lifecycle_root || !lifecycle_cgroup_id(path, id))
+        return;
+    ev = lifecycle_event_alloc(LIFECYCLE_RMDIR);
+    if (!ev)
+        return;
+    strscpy(ev->id, id, sizeof(ev->id));
+    lifecycle_queue_event(ev);
+}
+
+// Los procesos hijos de stress no hacen exec, así que solo llega el principal
+static void probe_sched_process_exec(void *data, struct task_struct *p, pid_t old_pid, struct linux_binprm *bprm) {
+    struct lifecycle_event *ev;
+
+    if (!thread_group_leader(p) || strcmp(p->comm, "stress") != 0)
+        return;
+    ev = lifecycle_event_alloc(LIFECYCLE_EXEC);
+    if (!ev)
+        return;
+    get_task_struct(p);
+    ev->task = p;
+    ev->pid = p->pid;
+    lifecycle_queue_event(ev);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 16, 0)
+static void probe_sched_process_exit(void *data, struct task_struct *p, bool group_dead)
+#else
+static void probe_sched_process_exit(void *data, struct task_struct *p)
+#endif
+{
+    struct lifecycle_event *ev;
+    struct task_cache_entry *tc;
+    char id[CONTAINER_ID_MAX] = "";
+    bool cached = false, container;
+
+    // Corre en el contexto del proceso que termina, sin dormir: solo marca la entrada
+    if (!thread_group_leader(p))
+        return;
+
+    spin_lock(&task_cache_lock);
+    tc = task_cache_lookup(p->pid, p->start_time);
+    if (tc) {
+        WRITE_ONCE(tc->exited, true);
+        cached = true;
+        if (tc->is_container)
+            strscpy(id, tc->id, sizeof(id));
+    }
+    spin_unlock(&task_cache_lock);
+
+    /*
+        Sin entrada en la caché puede ser un hijo de stress o un proceso cuyo
+        exec sigue en la cola; lifecycle_work lo resuelve con (pid, start_time)
+    */
+    container = cached ? id[0] != '\0' : strcmp(p->comm, "stress") == 0;
+    if (!READ_ONCE(lifecycle_active) || !container)
+        return;
+    ev = lifecycle_event_alloc(LIFECYCLE_EXIT);
+    if (!ev)
+        return;
+    ev->pid = p->pid;
+    ev->start_time = p->start_time;
+    strscpy(ev->id, id, sizeof(ev->id));
+    lifecycle_queue_event(ev);
+}
+
+static void lifecycle_mkdir(struct lifecycle_event *ev) {
+    u32 hash = jhash(ev->id, strlen(ev->id), 0);
+    struct container_entry *e;
+
+    // Ya conocido: el recorrido de una pasada lo encontró antes que el evento
+    if (registry_lookup(ev->id, hash))
+        return;
+    e = registry_add_cgroup(ev->cgrp, ev->id, hash);
+    if (!e)
+        return;
+    e->tracked = true;
+    e->start_ns = ev->timestamp_ns;
+}
+
+static void lifecycle_exec(struct lifecycle_event *ev) {
+    struct task_struct *task = ev->task;
+    struct task_cache_entry *tc;
+    struct container_entry *e;
+
+    tc = task_cache_get(task, sampler_generation);
+    if (!tc || !tc->is_container)
+        return;
+    strscpy(ev->id, tc->id, sizeof(ev->id));
+
+    e = registry_lookup(tc->id, tc->hash);
+    if (!e)
+        e = registry_add(task, tc->id, tc->hash, tc->cmdline);
+    if (!e)
+        return;
+    registry_adopt(e, task);
+    registry_set_task(e, task, tc->cmdline);
+    e->exit_ns = 0;
+}
+
+// La muestra final sale del propio cgroup, que Docker todavía no elimina cuando termina el proceso principal
+static void lifecycle_exit(struct lifecycle_event *ev) {
+    struct task_cache_entry *tc;
+    struct container_entry *e;
+    struct sysinfo si;
+
+    if (!ev->id[0]) {
+        tc = task_cache_lookup(ev->pid, ev->start_time);
+        if (!tc || !tc->is_container)
+            return;
+        strscpy(ev->id, tc->id, sizeof(ev->id));
+    }
+
+    e = registry_lookup(ev->id, jhash(ev->id, strlen(ev->id), 0));
+    if (!e || e->ignored || e->exit_ns || e->pid != ev->pid)
+        return;
+
+    si_meminfo(&si);
+    sysinfo_collect_container(e, &scratch->final, si.totalram * 4 / 1024);
+    e->exit_ns = ev->timestamp_ns;
+}
+
+static void lifecycle_rmdir(struct lifecycle_event *ev) {
+    struct container_entry *e;
+
+    e = registry_lookup(ev->id, jhash(ev->id, strlen(ev->id), 0));
+    if (!e)
+        return;
+    if (!e->ignored)
+        lifecycle_removed++;
+    exited_record(e, ev->timestamp_ns, true);
+    registry_remove(e);
+}
+
+static void lifecycle_work_fn(struct work_struct *work) {
+    struct lifecycle_event *ev, *tmp;
+    LIST_HEAD(events);
+
+    spin_lock_irq(&lifecycle_lock);
+    list_splice_init(&lifecycle_queue, &events);
+    lifecycle_pending = 0;
+    spin_unlock_irq(&lifecycle_lock);
+
+    list_for_each_entry_safe(ev, tmp, &events, node) {
+        switch (ev->type) {
+        case LIFECYCLE_MKDIR:
+            lifecycle_mkdir(ev);
+            break;
+        case LIFECYCLE_RMDIR:
+            lifecycle_rmdir(ev);
+            break;
+        case LIFECYCLE_EXEC:
+            lifecycle_exec(ev);
+            break;
+        case LIFECYCLE_EXIT:
+            lifecycle_exit(ev);
+            break;
+        }
+        trace_sysinfo_container_lifecycle(lifecycle_names[ev->type], ev->id, ev->pid);
+        list_del(&ev->node);
+        lifecycle_event_free(ev);
+    }
+}
+
+// Eventos que quedaron en la cola al descargar el módulo, sin procesar
+static void lifecycle_drain(void) {
+    struct lifecycle_event *ev, *tmp;
+
+    list_for_each_entry_safe(ev, tmp, &lifecycle_queue, node) {
+        list_del(&ev->node);
+        lifecycle_event_free(ev);
+    }
+    lifecycle_pending = 0;
+}
+
+struct sysinfo_probe {
+    const char *name;
+    void *func;
+    struct tracepoint *tp;              // NULL si no se encontró o no se pudo registrar
+};
+
+// El primero mantiene la caché de procesos; los demás son del seguimiento por eventos
+static struct sysinfo_probe sysinfo_probes[] = {
+    { "sched_process_exit", probe_sched_process_exit },
+    { "sched_process_exec", probe_sched_process_exec },
+    { "cgroup_mkdir", probe_cgroup_mkdir },
+    { "cgroup_rmdir", probe_cgroup_rmdir },
+};
+
+static void find_tracepoint(struct tracepoint *tp, void *priv) {
+    for (int i = 0; i < ARRAY_SIZE(sysinfo_probes); i++) {
+        if (strcmp(tp->name, sysinfo_probes[i].name) == 0)
+            sysinfo_probes[i].tp = tp;
+    }
+}
+
+static bool probe_register(struct sysinfo_probe *p) {
+    if (p->tp && tracepoint_probe_register(p->tp, p->func, NULL))
+        p->tp = NULL;
+    return p->tp;
+}
+
+static void probes_unregister(int first) {
+    for (int i = first; i < ARRAY_SIZE(sysinfo_probes); i++) {
+        if (sysinfo_probes[i].tp)
+            tracepoint_probe_unregister(sysinfo_probes[i].tp, sysinfo_probes[i].func, NULL);
+        sysinfo_probes[i].tp = NULL;
+    }
+    tracepoint_synchronize_unregister();
+}
+
+/*
+    Los tracepoints del scheduler y de cgroups no se exportan a módulos, se
+    buscan por nombre. Sin sched_process_exit la caché se sigue limpiando en
+    cada pasada; sin alguno de los cuatro no hay seguimiento por eventos y
+    los contenedores se dan de alta y de baja solo con las pasadas
+*/
+static void sysinfo_probes_register(void) {
+    struct cgroup *root;
+    bool ok;
+
+    for_each_kernel_tracepoint(find_tracepoint, NULL);
+
+    ok = probe_register(&sysinfo_probes[0]);
+    if (!ok)
+        printk(KERN_WARNING "sysinfo_202202906: sin tracepoint sched_process_exit, la caché se limpia por pasada\n");
+    if (!lifecycle_events)
+        return;
+
+    root = cgroup_get_from_path("/");
+    if (IS_ERR(root))
+        return;
+    lifecycle_root = root->root;
+    cgroup_put(root);
+
+    for (int i = 1; i < ARRAY_SIZE(sysinfo_probes); i++)
+        ok = probe_register(&sysinfo_probes[i]) && ok;
+
+    if (ok) {
+        WRITE_ONCE(lifecycle_active, true);
+        return;
+    }
+
+    // Un mkdir ya encolado sin su rmdir dejaría el contenedor en el registro
+    probes_unregister(1);
+    WRITE_ONCE(lifecycle_lost, true);
+    printk(KERN_WARNING "sysinfo_202202906: sin tracepoints de cgroups o de exec, los contenedores se siguen por pasada\n");
+}
+
+/*
+    Una pasada del sampler: actualiza el registro con los contenedores
+    activos y luego reserva un snapshot del tamaño exacto para sus métricas
+*/
+static struct sysinfo_snapshot *sysinfo_collect(void) {
+    struct sysinfo si;
+    struct sysinfo_snapshot *snap;
+    struct container_entry *e;
+    unsigned long total_memory_mb;
+    u64 gen = ++sampler_generation;
+    unsigned int seen, removed, skipped = 0;
+    u64 start, t;
+    int bkt;
+
+    start = phase_start(gen, SYSINFO_PHASE_DISCOVERY);
+    if (discover_cgroups)
+        seen = discover_by_cgroups(gen);
+    else
+        seen = discover_by_tasks(gen);
+    phase_end(gen, SYSINFO_PHASE_DISCOVERY, seen, start);
+
+    start = phase_start(gen, SYSINFO_PHASE_SWEEP);
+    removed = registry_sweep(gen);
+    phase_end(gen, SYSINFO_PHASE_SWEEP, removed, start);
+
+    snap = snapshot_alloc(seen);
+    if (!snap) {
+        dbg_add(DBG_CONTAINERS_SKIPPED, seen);
+        return NULL;
+    }
+
+    snap->generation = gen;
+    snap->events = SYSINFO_EV_SAMPLE;
+    if (removed)
+        snap->events |= SYSINFO_EV_REMOVED;
+
+    start = phase_start(gen, SYSINFO_PHASE_HOST);
+    si_meminfo(&si);
+    total_memory_mb = si.totalram * 4 / 1024; // Total RAM in MB
+
+    snap->timestamp_ns = ktime_get_ns();
+    snap->total_mb = total_memory_mb;
+    snap->free_mb = si.freeram * 4 / 1024;
+    snap->used_mb = (si.totalram - si.freeram) * 4 / 1024;
+    snap->cpu_usage_total = get_cpu_usage(snap);
+    phase_end(gen, SYSINFO_PHASE_HOST, snap->nr_cpus, start);
+
+    start = phase_start(gen, SYSINFO_PHASE_CONTAINERS);
+    hash_for_each(container_registry, bkt, e, node) {
+        // Los seguidos por eventos siguen en el registro después de terminar o sin haber aparecido
+        if (e->ignored || e->exit_ns || e->seen_gen != gen)
+            continue;
+        // Contenedores dados de alta fuera de la pasada no tienen lugar en el snapshot
+        if (snap->count >= seen) {
+            skipped++;
+            continue;
+        }
+        t = ktime_get_ns();
+        snap->events |= sysinfo_collect_container(e, &snap->containers[snap->count++], total_memory_mb);
+        t = ktime_get_ns() - t;
+        latency_record(&container_latency, t);
+        trace_sysinfo_container_collect(e->id, e->pid, t);
+    }
+    if (skipped)
+        dbg_add(DBG_CONTAINERS_SKIPPED, skipped);
+    phase_end(gen, SYSINFO_PHASE_CONTAINERS, snap->count, start);
+
+    return snap;
+}
+
+// El desglose por CPU va al final de la misma reserva
+static size_t snapshot_size(unsigned int capacity) {
+    struct sysinfo_snapshot *snap;
+
+    return size_add(struct_size(snap, containers, capacity),
+                    array_size(nr_cpu_ids, sizeof(struct cpu_sample)));
+}
+
+static struct sysinfo_snapshot *snapshot_alloc(unsigned int count) {
+    struct sysinfo_snapshot *snap;
+    unsigned int capacity;
+
+    spin_lock(&spare_lock);
+    snap = spare_snapshot;
+    spare_snapshot = NULL;
+    spin_unlock(&spare_lock);
+
+    if (snap && snap->capacity >= count) {
+        capacity = snap->capacity;
+        memset(snap, 0, snapshot_size(capacity));
+    } else {
+        kvfree(snap);
+        // Margen para que unas cuantas altas no obliguen a reservar otra vez
+        capacity = count + count / 4 + 8;
+        snap = kvzalloc(snapshot_size(capacity), GFP_KERNEL);
+        if (!snap) {
+            dbg_inc(DBG_ALLOC_FAILURES);
+            return NULL;
+        }
+    }
+
+    kref_init(&snap->ref);
+    snap->capacity = capacity;
+    snap->nr_cpus = nr_cpu_ids;
+    snap->cpus = (struct cpu_sample *)&snap->containers[capacity];
+    return snap;
+}
+
+static void snapshot_release(struct kref *ref) {
+    struct sysinfo_snapshot *snap = container_of(ref, struct sysinfo_snapshot, ref);
+
+    // Se conserva el de mayor capacidad y se libera el otro
+    spin_lock(&spare_lock);
+    if (!spare_snapshot || spare_snapshot->capacity < snap->capacity)
+        swap(snap, spare_snapshot);
+    spin_unlock(&spare_lock);
+    kvfree(snap);
+}
+
+static void snapshot_put(struct sysinfo_snapshot *snap) {
+    if (snap)
+        kref_put(&snap->ref, snapshot_release);
+}
+
+// Devuelve el snapshot publicado con una referencia extra para el lector
+static struct sysinfo_snapshot *snapshot_get_current(void) {
+    struct sysinfo_snapshot *snap;
+
+    // La referencia de publicación se suelta después de synchronize_rcu, así que aquí nunca es 0
+    rcu_read_lock();
+    snap = rcu_dereference(current_snapshot);
+    kref_get(&snap->ref);
+    rcu_read_unlock();
+    return snap;
+}
+
+/*
+    Anillo binario de snapshots para consumidores por mmap. El formato está
+    en sysinfo_202202906.h; cada slot tiene su propio contador seq (estilo
+    seqlock) y head indica la última muestra completa. Solo escribe el sampler
+*/
+static void *ring_buf;
+static size_t ring_size;
+
+static struct sysinfo_ring_header *ring_header(void) {
+    return ring_buf;
+}
+
+static struct sysinfo_ring_slot *ring_slot(u64 sample) {
+    struct sysinfo_ring_header *hdr = ring_header();
+
+    return ring_buf + hdr->header_size + (size_t)(sample % hdr->nr_slots) * hdr->slot_size;
+}
+
+static int ring_init(void) {
+    struct sysinfo_ring_header *hdr;
+    size_t slot_size;
+
+    BUILD_BUG_ON(sizeof(struct sysinfo_ring_header) % 8 || sizeof(struct sysinfo_ring_slot) % 8 ||
+                 sizeof(struct sysinfo_ring_record) % 8);
+
+    if (!ring_slots || !ring_max_records)
+        return -EINVAL;
+
+    slot_size = sizeof(struct sysinfo_ring_slot) + (size_t)ring_max_records * sizeof(struct sysinfo_ring_record);
+    ring_size = PAGE_ALIGN(sizeof(struct sysinfo_ring_header) + (size_t)ring_slots * slot_size);
+
+    // vmalloc_user entrega memoria en cero lista para remap_vmalloc_range
+    ring_buf = vmalloc_user(ring_size);
+    if (!ring_buf)
+        return -ENOMEM;
+
+    hdr = ring_header();
+    hdr->magic = SYSINFO_RING_MAGIC;
+    hdr->version = SYSINFO_RING_VERSION;
+    hdr->header_size = sizeof(struct sysinfo_ring_header);
+    hdr->slot_size = slot_size;
+    hdr->record_size = sizeof(struct sysinfo_ring_record);
+    hdr->nr_slots = ring_slots;
+    hdr->max_records = ring_max_records;
+    return 0;
+}
+
+static void ring_publish(const struct sysinfo_snapshot *snap) {
+    struct sysinfo_ring_header *hdr = ring_header();
+    struct sysinfo_ring_record *records;
+    struct sysinfo_ring_slot *slot;
+    u64 sample = hdr->head + 1;
+    u32 n = min_t(u32, snap->count, hdr->max_records);
+
+    slot = ring_slot(sample - 1);
+    records = (struct sysinfo_ring_record *)(slot + 1);
+
+    WRITE_ONCE(slot->seq, slot->seq + 1);
+    smp_wmb();
+
+    slot->sample = sample;
+    slot->timestamp_ns = snap->timestamp_ns;
+    slot->total_memory_mb = snap->total_mb;
+    slot->free_memory_mb = snap->free_mb;
+    slot->used_memory_mb = snap->used_mb;
+    slot->cpu_usage = snap->cpu_usage_total;
+    slot->nr_records = n;
+    slot->nr_containers = snap->count;
+
+    for (u32 i = 0; i < n; i++) {
+        const struct container_sample *c = &snap->containers[i];
+        struct sysinfo_ring_record *r = &records[i];
+
+        memset(r, 0, sizeof(*r));
+        strscpy(r->container_id, c->id, sizeof(r->container_id));
+        strscpy(r->name, c->comm, sizeof(r->name));
+        strscpy(r->cmdline, c->cmdline, sizeof(r->cmdline));
+        r->pid = c->pid;
+        r->cpu_percent = c->cpu_percentage;
+        r->mem_percent = c->mem_percentage;
+        r->cpu_usage_usec = c->cpu_usage_usec;
+        r->mem_usage_kb = c->mem_usage_kb;
+        r->read_kb = c->read_kb;
+        r->write_kb = c->write_kb;
+        r->io_read_ops = c->io_read_ops;
+        r->io_write_ops = c->io_write_ops;
+    }
+
+    smp_wmb();
+    WRITE_ONCE(slot->seq, slot->seq + 1);
+    smp_store_release(&hdr->head, sample);
+}
+
+static int ring_mmap(struct file *file, struct vm_area_struct *vma) {
+    // El anillo es de solo lectura para el espacio de usuario
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_clear(vma, VM_MAYWRITE);
+#else
+    vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+    return remap_vmalloc_range(vma, ring_buf, vma->vm_pgoff);
+}
+
+static const struct proc_ops ring_ops = {
+    .proc_mmap = ring_mmap,
+};
+
+/*
+    Generic netlink: cada muestra se difunde una sola vez al grupo multicast,
+    así varios agentes reciben los mismos datos con el costo de una recolección.
+    La familia no acepta comandos, solo envía SYSINFO_CMD_SAMPLE
+*/
+static const struct genl_multicast_group sysinfo_genl_mcgrps[] = {
+    { .name = SYSINFO_GENL_MCGRP },
+};
+
+static struct genl_family sysinfo_genl_family = {
+    .name = SYSINFO_GENL_NAME,
+    .version = SYSINFO_GENL_VERSION,
+    .module = THIS_MODULE,
+    .mcgrps = sysinfo_genl_mcgrps,
+    .n_mcgrps = ARRAY_SIZE(sysinfo_genl_mcgrps),
+};
+
+static int genl_fill_sample(struct sk_buff *skb, const struct sysinfo_snapshot *snap,
+                            const struct container_sample *c) {
+    void *hdr;
+
+    hdr = genlmsg_put(skb, 0, 0, &sysinfo_genl_family, 0, SYSINFO_CMD_SAMPLE);
+    if (!hdr)
+        return -EMSGSIZE;
+
+    if (nla_put_u64_64bit(skb, SYSINFO_ATTR_SAMPLE, snap->generation, SYSINFO_ATTR_PAD) ||
+        nla_put_u64_64bit(skb, SYSINFO_ATTR_TIMESTAMP_NS, snap->timestamp_ns, SYSINFO_ATTR_PAD) ||
+        nla_put_string(skb, SYSINFO_ATTR_CONTAINER_ID, c->id) ||
+        nla_put_u32(skb, SYSINFO_ATTR_PID, c->pid) ||
+        nla_put_string(skb, SYSINFO_ATTR_NAME, c->comm) ||
+        nla_put_string(skb, SYSINFO_ATTR_CMDLINE, c->cmdline) ||
+        nla_put_u32(skb, SYSINFO_ATTR_CPU_PERCENT, c->cpu_percentage) ||
+        nla_put_u64_64bit(skb, SYSINFO_ATTR_CPU_USAGE_USEC, c->cpu_usage_usec, SYSINFO_ATTR_PAD) ||
+        nla_put_u32(skb, SYSINFO_ATTR_MEM_PERCENT, c->mem_percentage) ||
+        nla_put_u64_64bit(skb, SYSINFO_ATTR_MEM_KB, c->mem_usage_kb, SYSINFO_ATTR_PAD) ||
+        nla_put_u64_64bit(skb, SYSINFO_ATTR_READ_KB, c->read_kb, SYSINFO_ATTR_PAD) ||
+        nla_put_u64_64bit(skb, SYSINFO_ATTR_WRITE_KB, c->write_kb, SYSINFO_ATTR_PAD) ||
+        nla_put_u64_64bit(skb, SYSINFO_ATTR_IO_READ_OPS, c->io_read_ops, SYSINFO_ATTR_PAD) ||
+        nla_put_u64_64bit(skb, SYSINFO_ATTR_IO_WRITE_OPS, c->io_write_ops, SYSINFO_ATTR_PAD)) {
+        genlmsg_cancel(skb, hdr);
+        return -EMSGSIZE;
+    }
+
+    genlmsg_end(skb, hdr);
+    return 0;
+}
+
+static void genl_publish(const struct sysinfo_snapshot *snap) {
+    struct sk_buff *skb;
+
+    // Sin suscriptores no se arma ningún mensaje
+    if (!genl_has_listeners(&sysinfo_genl_family, &init_net, 0))
+        return;
+
+    for (int i = 0; i < snap->count; i++) {
+        skb = genlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+        if (!skb) {
+            dbg_inc(DBG_ALLOC_FAILURES);
+            return;
+        }
+
+        if (genl_fill_sample(skb, snap, &snap->containers[i])) {
+            nlmsg_free(skb);
+            continue;
+        }
+        genlmsg_multicast(&sysinfo_genl_family, skb, 0, 0, GFP_KERNEL);
+    }
+}
+
+// Despierta a los lectores bloqueados en poll()/epoll sobre el archivo /proc
+static void sysinfo_notify(unsigned int events) {
+    if (!poll_on_sample)
+        events &= ~SYSINFO_EV_SAMPLE;
+    if (!events)
+        return;
+
+    atomic_inc(&sysinfo_event_seq);
+    wake_up_interruptible_poll(&sysinfo_wait, EPOLLIN | EPOLLRDNORM);
+}
+
+// Trabajo periódico: recolecta en un snapshot nuevo y lo publica para las lecturas
+static void sysinfo_sample_work(struct work_struct *work) {
+    struct sysinfo_snapshot *next, *old;
+    u64 start = ktime_get_ns(), t;
+
+    next = sysinfo_collect();
+    if (next) {
+        t = phase_start(next->generation, SYSINFO_PHASE_PUBLISH);
+        ring_publish(next);
+        genl_publish(next);
+
+        // Solo el sampler publica y corre en una workqueue ordenada
+        old = rcu_replace_pointer(current_snapshot, next, true);
+
+        sysinfo_notify(next->events);
+        phase_end(next->generation, SYSINFO_PHASE_PUBLISH, next->count, t);
+
+        // Los lectores que ya tomaron old conservan su propia referencia
+        synchronize_rcu();
+        snapshot_put(old);
+    }
+    latency_record(&sample_latency, ktime_get_ns() - start);
+
+    queue_delayed_work(sampler_wq, &sampler_work,
+                       msecs_to_jiffies(max(sample_period_ms, MIN_SAMPLE_PERIOD_MS)));
+}
+
+/*
+    Iterador del archivo /proc: la posición 0 es el encabezado con la memoria,
+    las posiciones 1..count son los contenedores y count + 1 cierra el JSON.
+    seq_read llama a start/next/stop por cada página, así que un registro que
+    no cabe en el buffer solo repite ese registro y no todo el documento
+*/
+struct sysinfo_iter {
+    struct sysinfo_snapshot *snap;
+    int event_seen;             // sysinfo_event_seq cuando se leyó desde el inicio por última vez
+    u64 chunk_start_ns;         // Inicio del start/stop actual
+    u64 show_ns;                // Tiempo dentro del módulo en la lectura actual, sin el de espacio de usuario
+    bool show_done;             // Ya se emitió el cierre del JSON
+};
+
+static char sysinfo_footer_token;
+
+static void *sysinfo_seq_elem(struct sysinfo_snapshot *snap, loff_t pos) {
+    if (pos == 0)
+        return SEQ_START_TOKEN;
+    if (pos <= snap->count)
+        return &snap->containers[pos - 1];
+    if (pos == snap->count + 1)
+        return &sysinfo_footer_token;
+    return NULL;
+}
+
+static void *sysinfo_seq_start(struct seq_file *m, loff_t *pos) {
+    struct sysinfo_iter *iter = m->private;
+
+    // Cada lectura desde el inicio toma la muestra más reciente
+    if (*pos == 0 || !iter->snap) {
+        iter->event_seen = atomic_read(&sysinfo_event_seq);
+        snapshot_put(iter->snap);
+        iter->snap = snapshot_get_current();
+        iter->show_ns = 0;
+        iter->show_done = false;
+    }
+    iter->chunk_start_ns = ktime_get_ns();
+    return sysinfo_seq_elem(iter->snap, *pos);
+}
+
+static void *sysinfo_seq_next(struct seq_file *m, void *v, loff_t *pos) {
+    struct sysinfo_iter *iter = m->private;
+
+    ++*pos;
+    return sysinfo_seq_elem(iter->snap, *pos);
+}
+
+static void sysinfo_seq_stop(struct seq_file *m, void *v) {
+    struct sysinfo_iter *iter = m->private;
+
+    // La referencia al snapshot se suelta en sysinfo_release
+    iter->show_ns += ktime_get_ns() - iter->chunk_start_ns;
+    if (iter->show_done) {
+        latency_record(&show_latency, iter->show_ns);
+        trace_sysinfo_show(iter->snap->count, iter->show_ns);
+        iter->show_done = false;
+        iter->show_ns = 0;
+    }
+}
+
+// Las métricas de CPU se guardan en centésimas de porcentaje (PCT está en sysinfo_202202906_core.h)
+static void sysinfo_show_cpu(struct seq_file *m, const struct sysinfo_snapshot *snap) {
+    const struct cpu_sample *c = &snap->cpu;
+    bool first = true;
+
+    seq_printf(m, "  \"CPU\": {\n");
+    seq_printf(m, "    \"Usage_Percentage\": %u.%02u,\n", PCT(c->usage));
+    seq_printf(m, "    \"User_Percentage\": %u.%02u,\n", PCT(c->user));
+    seq_printf(m, "    \"System_Percentage\": %u.%02u,\n", PCT(c->system));
+    seq_printf(m, "    \"Idle_Percentage\": %u.%02u,\n", PCT(c->idle));
+    seq_printf(m, "    \"Iowait_Percentage\": %u.%02u,\n", PCT(c->iowait));
+    seq_printf(m, "    \"Irq_Percentage\": %u.%02u,\n", PCT(c->irq));
+    seq_printf(m, "    \"Softirq_Percentage\": %u.%02u,\n", PCT(c->softirq));
+    seq_printf(m, "    \"Steal_Percentage\": %u.%02u,\n", PCT(c->steal));
+    seq_printf(m, "    \"Per_CPU\": [");
+
+    // Solo las CPUs en línea, una por renglón para ubicar núcleos saturados
+    for (unsigned int cpu = 0; cpu < snap->nr_cpus; cpu++) {
+        c = &snap->cpus[cpu];
+        if (!c->online)
+            continue;
+
+        seq_printf(m, "%s\n      { \"CPU\": %u, \"Usage_Percentage\": %u.%02u, \"User_Percentage\": %u.%02u, "
+                   "\"System_Percentage\": %u.%02u, \"Iowait_Percentage\": %u.%02u, \"Steal_Percentage\": %u.%02u }",
+                   first ? "" : ",", cpu, PCT(c->usage), PCT(c->user), PCT(c->system), PCT(c->iowait), PCT(c->steal));
+        first = false;
+    }
+
+    seq_printf(m, "\n    ]\n");
+    seq_printf(m, "  },\n");
+}
+
+static void sysinfo_show_header(struct seq_file *m, const struct sysinfo_snapshot *snap) {
+    seq_printf(m, "{\n");
+    seq_printf(m, "  \"Generation\": %llu,\n", snap->generation);
+    seq_printf(m, "  \"Memory\": {\n");
+    seq_printf(m, "    \"Total_Memory_MB\": %lu,\n", snap->total_mb);
+    seq_printf(m, "    \"Free_Memory_MB\": %lu,\n", snap->free_mb);
+    seq_printf(m, "    \"Used_Memory_MB\": %lu,\n", snap->used_mb);
+    seq_printf(m, "    \"CPU_Usage_Percentage\": %lu.%02lu\n", snap->cpu_usage_total / 100, snap->cpu_usage_total % 100);
+    seq_printf(m, "  },\n");
+
+    sysinfo_show_cpu(m, snap);
+
+    seq_printf(m, "  \"Docker_Containers\": [\n");
+}
+
+// Secciones opcionales según los parámetros actuales del módulo
+static struct sysinfo_show_opts sysinfo_show_opts_current(void) {
+    return (struct sysinfo_show_opts){
+        .throttling = collect_throttling || backend->cpu_stat == kernfs_cpu_stat,
+        .pressure = collect_pressure,
+        .io_devices = io_per_device,
+        .nr_memory_stat_keys = nr_memory_stat_keys,
+        .memory_stat_keys = memory_stat_keys,
+        .nr_stats_windows = nr_stats_windows,
+        .stats_windows = stats_windows,
+    };
+}
+
+static int sysinfo_seq_show(struct seq_file *m, void *v) {
+    struct sysinfo_iter *iter = m->private;
+    const struct container_sample *c;
+    struct sysinfo_show_opts opts;
+
+    if (v == SEQ_START_TOKEN) {
+        sysinfo_show_header(m, iter->snap);
+    } else if (v == &sysinfo_footer_token) {
+        seq_printf(m, "\n  ]\n");
+        seq_printf(m, "}\n");
+        iter->show_done = true;
+    } else {
+        c = v;
+        opts = sysinfo_show_opts_current();
+        sysinfo_show_container(m, c, c == &iter->snap->containers[0], NULL, &opts);
+    }
+    return 0;
+}
+
+static const struct seq_operations sysinfo_seq_ops = {
+    .start = sysinfo_seq_start,
+    .next = sysinfo_seq_next,
+    .stop = sysinfo_seq_stop,
+    .show = sysinfo_seq_show,
+};
+
+// Función que se ejecuta al abrir el archivo /proc
+static int sysinfo_open(struct inode *inode, struct file *file) {
+    if (!__seq_open_private(file, &sysinfo_seq_ops, sizeof(struct sysinfo_iter)))
+        return -ENOMEM;
+    return 0;
+}
+
+static int sysinfo_release(struct inode *inode, struct file *file) {
+    struct seq_file *m = file->private_data;
+    struct sysinfo_iter *iter = m->private;
+
+    snapshot_put(iter->snap);
+    return seq_release_private(inode, file);
+}
+
+/*
+    El archivo queda listo para leer cuando hubo un evento después de la
+    última lectura desde el inicio. El consumidor espera con poll/epoll,
+    hace lseek(fd, 0, SEEK_SET) y vuelve a leer el documento completo
+*/
+static __poll_t sysinfo_poll(struct file *file, poll_table *wait) {
+    struct seq_file *m = file->private_data;
+    struct sysinfo_iter *iter = m->private;
+
+    poll_wait(file, &sysinfo_wait, wait);
+    if (atomic_read(&sysinfo_event_seq) != READ_ONCE(iter->event_seen))
+        return EPOLLIN | EPOLLRDNORM;
+    return 0;
+}
+
+// Estructura de operaciones del archivo /proc
+static const struct proc_ops sysinfo_ops = {
+    .proc_open = sysinfo_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = sysinfo_release,
+    .proc_poll = sysinfo_poll,
+};
+
+/*
+    Modo delta (/proc/sysinfo_202202906_delta): cada descriptor abierto guarda
+    un cursor con los últimos valores que entregó de cada contenedor. Una
+    lectura desde el inicio solo incluye los contenedores nuevos ("added"),
+    los que cambiaron más que los umbrales delta_* ("changed") y los que
+    desaparecieron ("removed"). La primera lectura entrega todos como "added"
+*/
+enum {
+    DELTA_ADDED,
+    DELTA_CHANGED,
+    DELTA_REMOVED,
+};
+
+static const char *const delta_change_names[] = {
+    [DELTA_ADDED] = "added",
+    [DELTA_CHANGED] = "changed",
+    [DELTA_REMOVED] = "removed",
+};
+
+// Últimos valores que recibió el lector de un contenedor
+struct delta_cursor {
+    struct hlist_node node;
+    u32 hash;
+    u64 seen_pass;
+    unsigned long cpu_percentage;
+    unsigned long mem_percentage;
+    unsigned long read_kb;
+    unsigned long write_kb;
+    char id[CONTAINER_ID_MAX];
+};
+
+struct delta_record {
+    int change;
+    const struct container_sample *c;   // NULL en los registros "removed"
+    const char *id;
+};
+
+/*
+    base va primero para que sysinfo_poll funcione igual con este archivo.
+    Las diferencias de una pasada se calculan una sola vez y se entregan
+    completas aunque el lector haga varios read() o vuelva al inicio antes
+    de llegar al cierre del JSON; la siguiente pasada empieza después de eso
+*/
+struct sysinfo_delta_iter {
+    struct sysinfo_iter base;
+    DECLARE_HASHTABLE(cursors, DELTA_HASH_BITS);
+    unsigned int nr_cursors;
+    struct hlist_head removed;          // Cursores eliminados, se liberan en la siguiente pasada
+    struct delta_record *records;
+    unsigned int nr_records;
+    u64 pass;
+    bool pending;                       // Hay una pasada que todavía no se leyó hasta el final
+};
+
+static unsigned long delta_diff(unsigned long a, unsigned long b) {
+    return a > b ? a - b : b - a;
+}
+
+static bool delta_changed(const struct delta_cursor *cur, const struct container_sample *c) {
+    return delta_diff(c->cpu_percentage, cur->cpu_percentage) > delta_cpu_threshold ||
+           delta_diff(c->mem_percentage, cur->mem_percentage) > delta_mem_threshold ||
+           c->read_kb - cur->read_kb > delta_io_threshold_kb ||
+           c->write_kb - cur->write_kb > delta_io_threshold_kb;
+}
+
+static void delta_cursor_update(struct delta_cursor *cur, const struct container_sample *c) {
+    cur->cpu_percentage = c->cpu_percentage;
+    cur->mem_percentage = c->mem_percentage;
+    cur->read_kb = c->read_kb;
+    cur->write_kb = c->write_kb;
+}
+
+static struct delta_cursor *delta_cursor_lookup(struct sysinfo_delta_iter *iter, const char *id, u32 hash) {
+    struct delta_cursor *cur;
+
+    hash_for_each_possible(iter->cursors, cur, node, hash) {
+        if (cur->hash == hash && strcmp(cur->id, id) == 0)
+            return cur;
+    }
+    return NULL;
+}
+
+static void delta_free_removed(struct sysinfo_delta_iter *iter) {
+    struct delta_cursor *cur;
+    struct hlist_node *tmp;
+
+    hlist_for_each_entry_safe(cur, tmp, &iter->removed, node) {
+        hlist_del(&cur->node);
+        kfree(cur);
+    }
+}
+
+// Compara el snapshot actual con el cursor del lector y arma los registros de la pasada
+static int delta_build(struct sysinfo_delta_iter *iter) {
+    struct sysinfo_snapshot *snap = iter->base.snap;
+    struct delta_cursor *cur;
+    struct hlist_node *tmp;
+    unsigned int n = 0;
+    int bkt;
+
+    delta_free_removed(iter);
+    kvfree(iter->records);
+    iter->nr_records = 0;
+
+    // Cota: todos los contenedores del snapshot más todos los cursores que pueden desaparecer
+    iter->records = kvmalloc_array(snap->count + iter->nr_cursors, sizeof(*iter->records), GFP_KERNEL);
+    if (!iter->records)
+        return -ENOMEM;
+
+    iter->pass++;
+    for (int i = 0; i < snap->count; i++) {
+        const struct container_sample *c = &snap->containers[i];
+        u32 hash = jhash(c->id, strlen(c->id), 0);
+
+        cur = delta_cursor_lookup(iter, c->id, hash);
+        if (!cur) {
+            cur = kzalloc(sizeof(*cur), GFP_KERNEL);
+            // Sin memoria se omite, en la siguiente pasada vuelve a salir como "added"
+            if (!cur) {
+                dbg_inc(DBG_ALLOC_FAILURES);
+                continue;
+            }
+            cur->hash = hash;
+            strscpy(cur->id, c->id, sizeof(cur->id));
+            hash_add(iter->cursors, &cur->node, hash);
+            iter->nr_cursors++;
+            delta_cursor_update(cur, c);
+            iter->records[n++] = (struct delta_record){ DELTA_ADDED, c, cur->id };
+        } else if (delta_changed(cur, c)) {
+            // La base solo avanza cuando se envía, así los cambios lentos se acumulan
+            delta_cursor_update(cur, c);
+            iter->records[n++] = (struct delta_record){ DELTA_CHANGED, c, cur->id };
+        }
+        cur->seen_pass = iter->pass;
+    }
+
+    hash_for_each_safe(iter->cursors, bkt, tmp, cur, node) {
+        if (cur->seen_pass == iter->pass)
+            continue;
+        hash_del(&cur->node);
+        hlist_add_head(&cur->node, &iter->removed);
+        iter->nr_cursors--;
+        iter->records[n++] = (struct delta_record){ DELTA_REMOVED, NULL, cur->id };
+    }
+
+    iter->nr_records = n;
+    return 0;
+}
+
+static void *delta_seq_elem(struct sysinfo_delta_iter *iter, loff_t pos) {
+    if (pos == 0)
+        return SEQ_START_TOKEN;
+    if (pos <= iter->nr_records)
+        return &iter->records[pos - 1];
+    if (pos == iter->nr_records + 1)
+        return &sysinfo_footer_token;
+    return NULL;
+}
+
+static void *delta_seq_start(struct seq_file *m, loff_t *pos) {
+    struct sysinfo_delta_iter *iter = m->private;
+    int ret;
+
+    // Se toma antes de delta_build: armar el diff es parte del costo de la lectura
+    iter->base.chunk_start_ns = ktime_get_ns();
+    if (*pos == 0 && !iter->pending) {
+        iter->base.event_seen = atomic_read(&sysinfo_event_seq);
+        snapshot_put(iter->base.snap);
+        iter->base.snap = snapshot_get_current();
+        iter->base.show_ns = 0;
+        iter->base.show_done = false;
+
+        ret = delta_build(iter);
+        if (ret)
+            return ERR_PTR(ret);
+        iter->pending = true;
+    }
+    if (!iter->records)
+        return NULL;
+    return delta_seq_elem(iter, *pos);
+}
+
+static void *delta_seq_next(struct seq_file *m, void *v, loff_t *pos) {
+    ++*pos;
+    return delta_seq_elem(m->private, *pos);
+}
+
+static int delta_seq_show(struct seq_file *m, void *v) {
+    struct sysinfo_delta_iter *iter = m->private;
+    const struct delta_record *r;
+    struct sysinfo_show_opts opts;
+
+    if (v == SEQ_START_TOKEN) {
+        sysinfo_show_header(m, iter->base.snap);
+    } else if (v == &sysinfo_footer_token) {
+        seq_printf(m, "\n  ]\n");
+        seq_printf(m, "}\n");
+        iter->pending = false;
+        iter->base.show_done = true;
+    } else {
+        r = v;
+        if (r->c) {
+            opts = sysinfo_show_opts_current();
+            sysinfo_show_container(m, r->c, r == &iter->records[0], delta_change_names[r->change], &opts);
+        } else {
+            if (r != &iter->records[0])
+                seq_printf(m, ",\n");
+            seq_printf(m, "    {\n");
+            seq_printf(m, "      \"Change\": \"%s\",\n", delta_change_names[r->change]);
+            seq_printf(m, "      \"ContainerID\": \"%.12s\"\n", r->id);
+            seq_printf(m, "    }");
+        }
+    }
+    return 0;
+}
+
+static const struct seq_operations delta_seq_ops = {
+    .start = delta_seq_start,
+    .next = delta_seq_next,
+    .stop = sysinfo_seq_stop,
+    .show = delta_seq_show,
+};
+
+static int delta_open(struct inode *inode, struct file *file) {
+    struct sysinfo_delta_iter *iter;
+
+    iter = __seq_open_private(file, &delta_seq_ops, sizeof(*iter));
+    if (!iter)
+        return -ENOMEM;
+
+    hash_init(iter->cursors);
+    INIT_HLIST_HEAD(&iter->removed);
+    return 0;
+}
+
+static int delta_release(struct inode *inode, struct file *file) {
+    struct seq_file *m = file->private_data;
+    struct sysinfo_delta_iter *iter = m->private;
+    struct delta_cursor *cur;
+    struct hlist_node *tmp;
+    int bkt;
+
+    hash_for_each_safe(iter->cursors, bkt, tmp, cur, node) {
+        hash_del(&cur->node);
+        kfree(cur);
+    }
+    delta_free_removed(iter);
+    kvfree(iter->records);
+    snapshot_put(iter->base.snap);
+    return seq_release_private(inode, file);
+}
+
+static const struct proc_ops delta_ops = {
+    .proc_open = delta_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = delta_release,
+    .proc_poll = sysinfo_poll,
+};
+
+/*
+    /proc/sysinfo_202202906_exited: los contenedores terminados que siguen en
+    exited_ring, del más viejo al más nuevo. exited_lock se toma en start y se
+    suelta en stop, así que un registro no cambia mientras se formatea; entre
+    dos read() el anillo puede avanzar y el consumidor descarta por Seq
+*/
+static void *exited_seq_elem(loff_t pos) {
+    u64 nr = min_t(u64, exited_seq, exited_max);
+
+    if (pos == 0)
+        return SEQ_START_TOKEN;
+    if (pos <= nr)
+        return &exited_ring[(exited_seq - nr + pos - 1) % exited_max];
+    if (pos == nr + 1)
+        return &sysinfo_footer_token;
+    return NULL;
+}
+
+static void *exited_seq_start(struct seq_file *m, loff_t *pos) {
+    mutex_lock(&exited_lock);
+    return exited_seq_elem(*pos);
+}
+
+static void *exited_seq_next(struct seq_file *m, void *v, loff_t *pos) {
+    ++*pos;
+    return exited_seq_elem(*pos);
+}
+
+static void exited_seq_stop(struct seq_file *m, void *v) {
+    mutex_unlock(&exited_lock);
+}
+
+static int exited_seq_show(struct seq_file *m, void *v) {
+    const struct exited_container *x = v;
+
+    if (v == SEQ_START_TOKEN) {
+        seq_printf(m, "{\n");
+        seq_printf(m, "  \"Next_Seq\": %llu,\n", exited_seq);
+        seq_printf(m, "  \"Exited_Containers\": [");
+        return 0;
+    }
+    if (v == &sysinfo_footer_token) {
+        seq_printf(m, "\n  ]\n");
+        seq_printf(m, "}\n");
+        return 0;
+    }
+
+    seq_printf(m, "%s\n    {\n", x->seq == exited_seq - min_t(u64, exited_seq, exited_max) ? "" : ",");
+    seq_printf(m, "      \"Seq\": %llu,\n", x->seq);
+    seq_printf(m, "      \"PID\": %d,\n", x->pid);
+    seq_printf(m, "      \"Name\": \"%s\",\n", x->comm);
+    seq_printf(m, "      \"ContainerID\": \"%.12s\",\n", x->id);
+    seq_printf(m, "      \"Cmdline\": \"%s\",\n", x->cmdline);
+    seq_printf(m, "      \"Start_ns\": %llu,\n", x->start_ns);
+    seq_printf(m, "      \"Start_Exact\": %s,\n", x->start_exact ? "true" : "false");
+    seq_printf(m, "      \"Stop_ns\": %llu,\n", x->stop_ns);
+    seq_printf(m, "      \"Stop_Exact\": %s,\n", x->stop_exact ? "true" : "false");
+    seq_printf(m, "      \"Lifetime_ms\": %llu,\n",
+               x->stop_ns > x->start_ns ? div_u64(x->stop_ns - x->start_ns, NSEC_PER_MSEC) : 0);
+    seq_printf(m, "      \"Samples\": %llu,\n", x->nr_samples);
+    seq_printf(m, "      \"CPUUsage_usec\": %lu,\n", x->cpu_usage_usec);
+    seq_printf(m, "      \"MaxMemoryUsage_KB\": %lu,\n", x->max_mem_kb);
+    seq_printf(m, "      \"Write_KBytes\": %lu,\n", x->write_kb);
+    seq_printf(m, "      \"Read_KBytes\": %lu,\n", x->read_kb);
+    seq_printf(m, "      \"IOReadOps\": %lu,\n", x->io_read_ops);
+    seq_printf(m, "      \"IOWriteOps\": %lu\n", x->io_write_ops);
+    seq_printf(m, "    }");
+    return 0;
+}
+
+static const struct seq_operations exited_seq_ops = {
+    .start = exited_seq_start,
+    .next = exited_seq_next,
+    .stop = exited_seq_stop,
+    .show = exited_seq_show,
+};
+
+static int exited_open(struct inode *inode, struct file *file) {
+    return seq_open(file, &exited_seq_ops);
+}
+
+static const struct proc_ops exited_ops = {
+    .proc_open = exited_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = seq_release,
+};
+
+static int dbg_counters_show(struct seq_file *m, void *v) {
+    for (int i = 0; i < NR_DBG_COUNTERS; i++)
+        seq_printf(m, "%s %lld\n", dbg_counter_names[i], atomic64_read(&dbg_counters[i]));
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(dbg_counters);
+
+static int latency_hist_show(struct seq_file *m, void *v) {
+    struct latency_hist *h = m->private;
+
+    seq_printf(m, "count %lld\n", atomic64_read(&h->count));
+    seq_printf(m, "sum_ns %lld\n", atomic64_read(&h->sum_ns));
+    seq_printf(m, "max_ns %lld\n", atomic64_read(&h->max_ns));
+    for (int b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+        s64 n = atomic64_read(&h->buckets[b]);
+
+        if (n)
+            seq_printf(m, "[%llu, %llu) %lld\n", b ? 1ULL << b : 0, 1ULL << (b + 1), n);
+    }
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(latency_hist);
+
+static void latency_hist_reset(struct latency_hist *h) {
+    atomic64_set(&h->count, 0);
+    atomic64_set(&h->sum_ns, 0);
+    atomic64_set(&h->max_ns, 0);
+    for (int b = 0; b < LATENCY_HIST_BUCKETS; b++)
+        atomic64_set(&h->buckets[b], 0);
+}
+
+static ssize_t dbg_reset_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos) {
+    for (int i = 0; i < NR_DBG_COUNTERS; i++)
+        atomic64_set(&dbg_counters[i], 0);
+    latency_hist_reset(&show_latency);
+    latency_hist_reset(&sample_latency);
+    latency_hist_reset(&container_latency);
+    return count;
+}
+
+static const struct file_operations dbg_reset_fops = {
+    .owner = THIS_MODULE,
+    .write = dbg_reset_write,
+};
+
+// Sin debugfs el módulo funciona igual, solo sin estos archivos
+static void sysinfo_debugfs_init(void) {
+    debug_dir = debugfs_create_dir(PROC_NAME, NULL);
+    debugfs_create_file("counters", 0444, debug_dir, NULL, &dbg_counters_fops);
+    debugfs_create_file("show_latency_ns", 0444, debug_dir, &show_latency, &latency_hist_fops);
+    debugfs_create_file("sample_latency_ns", 0444, debug_dir, &sample_latency, &latency_hist_fops);
+    debugfs_create_file("container_latency_ns", 0444, debug_dir, &container_latency, &latency_hist_fops);
+    debugfs_create_file("reset", 0200, debug_dir, NULL, &dbg_reset_fops);
+}
+
+// Inicialización del módulo
+static int __init sysinfo_init(void) {
+    struct sysinfo_snapshot *snap;
+    int ret;
+
+    for (int i = 0; i < ARRAY_SIZE(collect_backends); i++) {
+        if (strcmp(collect_backend, collect_backends[i].name) == 0)
+            backend = &collect_backends[i];
+    }
+    if (!backend) {
+        printk(KERN_ERR "sysinfo_202202906: backend desconocido '%s'\n", collect_backend);
+        return -EINVAL;
+    }
+
+    if (strcmp(discovery, "cgroups") == 0) {
+        discover_cgroups = true;
+    } else if (strcmp(discovery, "tasks") != 0) {
+        printk(KERN_ERR "sysinfo_202202906: modo de descubrimiento desconocido '%s'\n", discovery);
+        return -EINVAL;
+    }
+
+    stats_init();
+
+    ret = memory_stat_init();
+    if (ret)
+        return ret;
+
+    scratch = kzalloc(sizeof(*scratch), GFP_KERNEL);
+    if (!scratch)
+        return -ENOMEM;
+    scratch->reader = (struct cgroup_reader){
+        .ops = &sysinfo_file_ops,
+        .path = scratch->path,
+        .buf = scratch->buf,
+        .buf_size = sizeof(scratch->buf),
+        .io = &scratch->io,
+    };
+
+    entry_cache = KMEM_CACHE(container_entry, 0);
+    if (!entry_cache) {
+        ret = -ENOMEM;
+        goto err_scratch;
+    }
+
+    task_cache_cachep = KMEM_CACHE(task_cache_entry, 0);
+    if (!task_cache_cachep) {
+        ret = -ENOMEM;
+        goto err_cache;
+    }
+
+    exited_ring = kvcalloc(exited_max, sizeof(*exited_ring), GFP_KERNEL);
+    if (!exited_ring) {
+        ret = -ENOMEM;
+        goto err_task_cache;
+    }
+
+    snap = snapshot_alloc(0);
+    if (!snap) {
+        ret = -ENOMEM;
+        goto err_exited;
+    }
+    RCU_INIT_POINTER(current_snapshot, snap);
+
+    ret = ring_init();
+    if (ret)
+        goto err_snapshot;
+
+    sampler_wq = alloc_ordered_workqueue("sysinfo_sampler", 0);
+    if (!sampler_wq) {
+        ret = -ENOMEM;
+        goto err_ring;
+    }
+
+    if (!proc_create(PROC_NAME, 0, NULL, &sysinfo_ops)) {
+        ret = -ENOMEM;
+        goto err_wq;
+    }
+
+    if (!proc_create(SYSINFO_RING_PROC, 0444, NULL, &ring_ops)) {
+        ret = -ENOMEM;
+        goto err_proc;
+    }
+
+    if (!proc_create(DELTA_PROC_NAME, 0, NULL, &delta_ops)) {
+        ret = -ENOMEM;
+        goto err_ring_proc;
+    }
+
+    if (!proc_create(EXITED_PROC_NAME, 0444, NULL, &exited_ops)) {
+        ret = -ENOMEM;
+        goto err_delta_proc;
+    }
+
+    ret = genl_register_family(&sysinfo_genl_family);
+    if (ret)
+        goto err_exited_proc;
+
+    INIT_WORK(&lifecycle_work, lifecycle_work_fn);
+    if (!discover_cgroups || lifecycle_events)
+        sysinfo_probes_register();
+
+    sysinfo_debugfs_init();
+
+    // La primera muestra se toma de inmediato, las siguientes cada sample_period_ms
+    INIT_DELAYED_WORK(&sampler_work, sysinfo_sample_work);
+    queue_delayed_work(sampler_wq, &sampler_work, 0);
+
+    printk(KERN_INFO "sysinfo_202202906: Módulo cargado\n");
+    return 0;
+
+err_exited_proc:
+    remove_proc_entry(EXITED_PROC_NAME, NULL);
+err_delta_proc:
+    remove_proc_entry(DELTA_PROC_NAME, NULL);
+err_ring_proc:
+    remove_proc_entry(SYSINFO_RING_PROC, NULL);
+err_proc:
+    remove_proc_entry(PROC_NAME, NULL);
+err_wq:
+    destroy_workqueue(sampler_wq);
+err_ring:
+    vfree(ring_buf);
+err_snapshot:
+    snapshot_put(snap);
+    kvfree(spare_snapshot);
+err_exited:
+    kvfree(exited_ring);
+err_task_cache:
+    kmem_cache_destroy(task_cache_cachep);
+err_cache:
+    kmem_cache_destroy(entry_cache);
+err_scratch:
+    kfree(scratch);
+    return ret;
 }
 
 // Eliminación del módulo
 static void __exit sysinfo_exit(void) {
+    remove_proc_entry(EXITED_PROC_NAME, NULL);
+    remove_proc_entry(DELTA_PROC_NAME, NULL);
+    remove_proc_entry(SYSINFO_RING_PROC, NULL);
     remove_proc_entry(PROC_NAME, NULL);
+    debugfs_remove_recursive(debug_dir);
+
+    // Sin probes ya nadie encola eventos en sampler_wq
+    probes_unregister(0);
+    cancel_delayed_work_sync(&sampler_work);
+    cancel_work_sync(&lifecycle_work);
+    lifecycle_drain();
+    destroy_workqueue(sampler_wq);
+    genl_unregister_family(&sysinfo_genl_family);
+    task_cache_sweep(0);
+    kmem_cache_destroy(task_cache_cachep);
+    vfree(ring_buf);
+    registry_sweep(0);
+    snapshot_put(rcu_dereference_protected(current_snapshot, true));
+    kvfree(spare_snapshot);
+    kmem_cache_destroy(entry_cache);
+    kvfree(exited_ring);
+    kvfree(scratch->tasks);
+    kfree(scratch);
     printk(KERN_INFO "sysinfo_202202906: Módulo descargado\n");
 }
 
 module_init(sysinfo_init);
-module_exit(sysinfo_exit);
\ No newline at end of file
+module_exit(sysinfo_exit);
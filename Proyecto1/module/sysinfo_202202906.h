@@ -0,0 +1,111 @@
+/*
+    Formatos binarios que el módulo sysinfo_202202906 comparte con el espacio
+    de usuario. Este header se puede incluir tanto desde el módulo como desde
+    programas de usuario (solo depende de <linux/types.h>)
+*/
+#ifndef _SYSINFO_202202906_H
+#define _SYSINFO_202202906_H
+
+#include <linux/types.h>
+
+/*
+    Anillo de snapshots: /proc/sysinfo_202202906_ring se mapea con mmap
+    (solo lectura) y contiene un sysinfo_ring_header seguido de nr_slots
+    slots de slot_size bytes. Cada slot es un sysinfo_ring_slot seguido de
+    max_records registros sysinfo_ring_record.
+
+    Lectura de la última muestra sin syscalls:
+      1. head = header->head (con acquire). Si es 0 todavía no hay muestras.
+      2. slot = base + header_size + ((head - 1) % nr_slots) * slot_size
+      3. seq = slot->seq (con acquire); si es impar el módulo está escribiendo, reintentar.
+      4. Copiar el slot y sus nr_records registros.
+      5. Si slot->seq cambió respecto al paso 3, la copia no es válida, reintentar.
+*/
+#define SYSINFO_RING_PROC       "sysinfo_202202906_ring"
+#define SYSINFO_RING_MAGIC      0x49535953 /* "SYSI" en little endian */
+#define SYSINFO_RING_VERSION    1
+#define SYSINFO_RING_ID_LEN     72
+#define SYSINFO_RING_NAME_LEN   16
+#define SYSINFO_RING_CMDLINE_LEN 256
+
+struct sysinfo_ring_header {
+    __u32 magic;
+    __u32 version;
+    __u32 header_size;      /* Bytes desde el inicio del mapeo hasta el primer slot */
+    __u32 slot_size;
+    __u32 record_size;
+    __u32 nr_slots;
+    __u32 max_records;      /* Registros por slot */
+    __u32 reserved0;
+    __u64 head;             /* Muestras publicadas; la última está en el slot (head - 1) % nr_slots */
+    __u64 reserved[3];
+};
+
+struct sysinfo_ring_slot {
+    __u64 seq;              /* Impar mientras el módulo escribe el slot */
+    __u64 sample;           /* Número de muestra (valor de head al publicarla) */
+    __u64 timestamp_ns;     /* CLOCK_MONOTONIC */
+    __u64 total_memory_mb;
+    __u64 free_memory_mb;
+    __u64 used_memory_mb;
+    __u32 cpu_usage;        /* Centésimas de porcentaje */
+    __u32 nr_records;
+    __u32 nr_containers;    /* Contenedores en la muestra, puede ser mayor que nr_records */
+    __u32 reserved;
+};
+
+struct sysinfo_ring_record {
+    char container_id[SYSINFO_RING_ID_LEN];
+    char name[SYSINFO_RING_NAME_LEN];
+    char cmdline[SYSINFO_RING_CMDLINE_LEN];
+    __s32 pid;
+    __u32 cpu_percent;      /* Centésimas de porcentaje */
+    __u32 mem_percent;      /* Centésimas de porcentaje */
+    __u32 reserved;
+    __u64 cpu_usage_usec;
+    __u64 mem_usage_kb;
+    __u64 read_kb;
+    __u64 write_kb;
+    __u64 io_read_ops;
+    __u64 io_write_ops;
+};
+
+/*
+    Familia de generic netlink: después de cada muestra el módulo envía un
+    mensaje SYSINFO_CMD_SAMPLE por contenedor al grupo multicast "samples".
+    Para recibirlos basta resolver la familia y el grupo con CTRL_CMD_GETFAMILY
+    (por ejemplo con libnl: genl_ctrl_resolve_grp) y suscribirse al grupo
+*/
+#define SYSINFO_GENL_NAME       "sysinfo_202202906"
+#define SYSINFO_GENL_VERSION    1
+#define SYSINFO_GENL_MCGRP      "samples"
+
+enum sysinfo_genl_cmd {
+    SYSINFO_CMD_UNSPEC,
+    SYSINFO_CMD_SAMPLE,
+    __SYSINFO_CMD_MAX,
+};
+#define SYSINFO_CMD_MAX (__SYSINFO_CMD_MAX - 1)
+
+enum sysinfo_genl_attr {
+    SYSINFO_ATTR_UNSPEC,
+    SYSINFO_ATTR_PAD,
+    SYSINFO_ATTR_SAMPLE,            /* u64, número de muestra */
+    SYSINFO_ATTR_TIMESTAMP_NS,      /* u64, CLOCK_MONOTONIC */
+    SYSINFO_ATTR_CONTAINER_ID,      /* string, ID completo */
+    SYSINFO_ATTR_PID,               /* u32 */
+    SYSINFO_ATTR_NAME,              /* string */
+    SYSINFO_ATTR_CMDLINE,           /* string */
+    SYSINFO_ATTR_CPU_PERCENT,       /* u32, centésimas de porcentaje */
+    SYSINFO_ATTR_CPU_USAGE_USEC,    /* u64 */
+    SYSINFO_ATTR_MEM_PERCENT,       /* u32, centésimas de porcentaje */
+    SYSINFO_ATTR_MEM_KB,            /* u64 */
+    SYSINFO_ATTR_READ_KB,           /* u64 */
+    SYSINFO_ATTR_WRITE_KB,          /* u64 */
+    SYSINFO_ATTR_IO_READ_OPS,       /* u64 */
+    SYSINFO_ATTR_IO_WRITE_OPS,      /* u64 */
+    __SYSINFO_ATTR_MAX,
+};
+#define SYSINFO_ATTR_MAX (__SYSINFO_ATTR_MAX - 1)
+
+#endif /* _SYSINFO_202202906_H */
@@ -0,0 +1,646 @@
+/*
+    Núcleo del módulo sysinfo_202202906 que no depende del resto del kernel:
+    los tipos de las métricas de un contenedor, los parsers de los archivos
+    de estadísticas de cgroupfs, qué archivos se leen de cada contenedor y en
+    qué orden, y el formato JSON de cada contenedor.
+
+    Se compila dentro del módulo y también en espacio de usuario con
+    bench/sysinfo_shim.h, que implementa lo poco que usa (kstrto*, strsep,
+    seq_printf, ...). Nada de aquí reserva memoria, y los archivos se abren y
+    leen con las funciones de cgroup_file_ops que entrega el que lo usa
+*/
+#ifndef _SYSINFO_202202906_CORE_H
+#define _SYSINFO_202202906_CORE_H
+
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <linux/string.h>
+#include <linux/stddef.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/limits.h>
+#else
+#include "sysinfo_shim.h"
+#endif
+
+#define MAX_CMDLINE_LENGTH 256
+#define CONTAINER_ID_MAX 65
+#define STATS_MAX_WINDOWS 4
+#define MAX_MEMORY_STAT_KEYS 8
+#define IO_MAX_DEVICES 8
+
+// Métricas con estadísticas por ventana
+enum {
+    STAT_CPU,           // Centésimas de porcentaje
+    STAT_MEM,           // KB
+    STAT_IOPS,          // Operaciones de I/O por segundo
+    NR_STAT_METRICS,
+};
+
+struct metric_stats {
+    u32 min;
+    u32 max;
+    u32 mean;
+    u32 p95;            // Aproximado con un histograma logarítmico
+};
+
+struct window_stats {
+    u32 samples;
+    struct metric_stats m[NR_STAT_METRICS];
+};
+
+// Contadores de io.stat de un dispositivo
+struct io_device_stat {
+    unsigned int major;
+    unsigned int minor;
+    u64 rbytes;
+    u64 wbytes;
+    u64 rios;
+    u64 wios;
+};
+
+struct io_stat {
+    struct io_device_stat total;        // Suma de todos los dispositivos (major/minor en 0)
+    unsigned int nr_devices;            // Puede ser mayor que IO_MAX_DEVICES
+    struct io_device_stat devices[IO_MAX_DEVICES];
+};
+
+// cpu.stat: usage_usec y los contadores de throttling de CFS
+struct cpu_stat {
+    u64 usage_usec;
+    u64 nr_periods;
+    u64 nr_throttled;
+    u64 throttled_usec;
+};
+
+// Una línea de un archivo *.pressure ("some" o "full")
+struct psi_stat {
+    u64 avg10;                          // Centésimas de porcentaje
+    u64 avg60;                          // Centésimas de porcentaje
+    u64 total;                          // Microsegundos acumulados con tareas detenidas
+};
+
+struct psi_resource_stat {
+    struct psi_stat some;
+    struct psi_stat full;
+};
+
+enum {
+    SYSINFO_PSI_CPU,
+    SYSINFO_PSI_MEMORY,
+    SYSINFO_PSI_IO,
+    NR_SYSINFO_PSI,
+};
+
+struct memory_stat {
+    u64 kernel;
+    u64 kernel_stack;
+    u64 extra[MAX_MEMORY_STAT_KEYS];    // En el orden de memory_stat_keys
+};
+
+// Métricas de un contenedor tomadas por el sampler
+struct container_sample {
+    char id[CONTAINER_ID_MAX];
+    char comm[TASK_COMM_LEN];
+    char cmdline[MAX_CMDLINE_LENGTH];
+    pid_t pid;
+    unsigned long cpu_usage_usec;   // usage_usec acumulado de cpu.stat
+    unsigned long cpu_percentage;   // Centésimas de porcentaje
+    unsigned long mem_usage_kb;
+    unsigned long mem_percentage;   // Centésimas de porcentaje
+    unsigned long read_kb;
+    unsigned long write_kb;
+    unsigned long io_read_ops;
+    unsigned long io_write_ops;
+    u64 nr_periods;
+    u64 nr_throttled;
+    u64 throttled_usec;
+    struct psi_resource_stat psi[NR_SYSINFO_PSI];
+    u64 memory_stat[MAX_MEMORY_STAT_KEYS];
+    unsigned int nr_io_devices;
+    struct io_device_stat io_devices[IO_MAX_DEVICES];
+    struct window_stats stats[STATS_MAX_WINDOWS];
+};
+
+/*
+    Separador de líneas por bloques: el que lee el archivo escribe cada bloque
+    en stat_lines_space() y llama a stat_lines_feed(), que entrega cada línea
+    completa a parse_line una sola vez. Una línea más larga que el buffer se
+    descarta completa. Al terminar, stat_lines_finish() entrega la última
+    línea si el archivo no termina en '\n'
+*/
+struct stat_line_reader {
+    char *buf;
+    size_t size;                        // Capacidad sin el '\0' final
+    size_t fill;
+    bool skip;
+    void (*parse_line)(char *line, void *ctx);
+    void *ctx;
+};
+
+static inline void stat_lines_init(struct stat_line_reader *r, char *buf, size_t bufsize,
+                                   void (*parse_line)(char *line, void *ctx), void *ctx) {
+    *r = (struct stat_line_reader){
+        .buf = buf, .size = bufsize - 1, .parse_line = parse_line, .ctx = ctx,
+    };
+}
+
+static inline char *stat_lines_space(const struct stat_line_reader *r, size_t *len) {
+    *len = r->size - r->fill;
+    return r->buf + r->fill;
+}
+
+static inline void stat_lines_feed(struct stat_line_reader *r, size_t n) {
+    char *buf = r->buf, *line = buf, *nl;
+
+    r->fill += n;
+    while ((nl = memchr(line, '\n', buf + r->fill - line))) {
+        *nl = '\0';
+        if (!r->skip)
+            r->parse_line(line, r->ctx);
+        r->skip = false;
+        line = nl + 1;
+    }
+
+    // Lo que queda es una línea incompleta, se mueve al inicio para el siguiente bloque
+    r->fill = buf + r->fill - line;
+    if (r->fill == r->size) {
+        r->skip = true;
+        r->fill = 0;
+    } else {
+        memmove(buf, line, r->fill);
+    }
+}
+
+static inline void stat_lines_finish(struct stat_line_reader *r) {
+    if (r->fill && !r->skip) {
+        r->buf[r->fill] = '\0';
+        r->parse_line(r->buf, r->ctx);
+    }
+    r->fill = 0;
+}
+
+// Campo de una tabla de claves: el valor se guarda como u64 en offset dentro del destino
+struct stat_field {
+    const char *key;
+    size_t offset;
+    bool centi;                         // Valor con dos decimales ("12.34"), se guarda en centésimas
+};
+
+// "entero.dd" a centésimas, como los promedios de los archivos *.pressure
+static inline int kstrtocenti(char *value, u64 *res) {
+    char *frac = strchr(value, '.');
+    unsigned int cents = 0;
+    int ret;
+
+    if (frac) {
+        *frac++ = '\0';
+        if (strlen(frac) != 2 || kstrtouint(frac, 10, &cents) < 0)
+            return -EINVAL;
+    }
+    ret = kstrtou64(value, 10, res);
+    if (!ret)
+        *res = *res * 100 + cents;
+    return ret;
+}
+
+static inline void stat_set_field(const struct stat_field *fields, int nr_fields, void *dst,
+                                  const char *key, char *value) {
+    for (int i = 0; i < nr_fields; i++) {
+        if (strcmp(key, fields[i].key) == 0) {
+            u64 *field = (u64 *)((char *)dst + fields[i].offset);
+            int ret = fields[i].centi ? kstrtocenti(value, field) : kstrtou64(value, 10, field);
+
+            if (ret < 0)
+                *field = 0;
+            return;
+        }
+    }
+}
+
+// Formato "clave valor" de memory.stat y cpu.stat
+struct flat_stat_ctx {
+    const struct stat_field *fields;
+    int nr_fields;
+    void *dst;
+};
+
+static inline void flat_stat_parse_line(char *line, void *ctx) {
+    struct flat_stat_ctx *flat = ctx;
+    char *value = strchr(line, ' ');
+
+    if (!value)
+        return;
+    *value++ = '\0';
+    stat_set_field(flat->fields, flat->nr_fields, flat->dst, line, value);
+}
+
+static const struct stat_field cpu_stat_fields[] = {
+    { .key = "usage_usec", .offset = offsetof(struct cpu_stat, usage_usec) },
+    { .key = "nr_periods", .offset = offsetof(struct cpu_stat, nr_periods) },
+    { .key = "nr_throttled", .offset = offsetof(struct cpu_stat, nr_throttled) },
+    { .key = "throttled_usec", .offset = offsetof(struct cpu_stat, throttled_usec) },
+};
+
+/*
+    *.pressure: "some avg10=0.00 avg60=0.00 avg300=0.00 total=0" y la misma
+    línea con "full". Se leen los archivos y no cgrp->psi porque el kernel
+    solo actualiza los promedios de un grupo inactivo al mostrar el archivo
+*/
+static const struct stat_field psi_stat_fields[] = {
+    { .key = "avg10", .offset = offsetof(struct psi_stat, avg10), .centi = true },
+    { .key = "avg60", .offset = offsetof(struct psi_stat, avg60), .centi = true },
+    { .key = "total", .offset = offsetof(struct psi_stat, total) },
+};
+
+static const char *const psi_files[NR_SYSINFO_PSI] = {
+    [SYSINFO_PSI_CPU] = "cpu.pressure",
+    [SYSINFO_PSI_MEMORY] = "memory.pressure",
+    [SYSINFO_PSI_IO] = "io.pressure",
+};
+
+static inline void psi_parse_line(char *line, void *ctx) {
+    struct psi_resource_stat *res = ctx;
+    struct psi_stat *ps;
+    char *tok, *value;
+
+    tok = strsep(&line, " ");
+    if (strcmp(tok, "some") == 0)
+        ps = &res->some;
+    else if (strcmp(tok, "full") == 0)
+        ps = &res->full;
+    else
+        return;
+
+    while ((tok = strsep(&line, " "))) {
+        value = strchr(tok, '=');
+        if (!value)
+            continue;
+        *value++ = '\0';
+        stat_set_field(psi_stat_fields, ARRAY_SIZE(psi_stat_fields), ps, tok, value);
+    }
+}
+
+// io.stat: una línea "MAJ:MIN rbytes=.. wbytes=.. rios=.. wios=.. ..." por dispositivo
+static const struct stat_field io_stat_fields[] = {
+    { .key = "rbytes", .offset = offsetof(struct io_device_stat, rbytes) },
+    { .key = "wbytes", .offset = offsetof(struct io_device_stat, wbytes) },
+    { .key = "rios", .offset = offsetof(struct io_device_stat, rios) },
+    { .key = "wios", .offset = offsetof(struct io_device_stat, wios) },
+};
+
+static inline void io_stat_parse_line(char *line, void *ctx) {
+    struct io_stat *st = ctx;
+    struct io_device_stat dev = {};
+    char *tok, *value;
+
+    tok = strsep(&line, " ");
+    if (sscanf(tok, "%u:%u", &dev.major, &dev.minor) != 2)
+        return;
+
+    while ((tok = strsep(&line, " "))) {
+        value = strchr(tok, '=');
+        if (!value)
+            continue;
+        *value++ = '\0';
+        stat_set_field(io_stat_fields, ARRAY_SIZE(io_stat_fields), &dev, tok, value);
+    }
+
+    // El total suma todos los dispositivos, el detalle guarda los primeros IO_MAX_DEVICES
+    st->total.rbytes += dev.rbytes;
+    st->total.wbytes += dev.wbytes;
+    st->total.rios += dev.rios;
+    st->total.wios += dev.wios;
+    if (st->nr_devices < IO_MAX_DEVICES)
+        st->devices[st->nr_devices] = dev;
+    st->nr_devices++;
+}
+
+/*
+    memory.stat: las dos primeras claves son las que usa el cálculo de memoria
+    de los contenedores con --hdd, el resto son las de memory_stat_keys.
+    Devuelve cuántos campos quedaron en la tabla
+*/
+#define MEMORY_STAT_MAX_FIELDS (2 + MAX_MEMORY_STAT_KEYS)
+
+static inline int memory_stat_fields_init(struct stat_field *fields, char *const *keys, int nr_keys) {
+    fields[0] = (struct stat_field){ .key = "kernel", .offset = offsetof(struct memory_stat, kernel) };
+    fields[1] = (struct stat_field){ .key = "kernel_stack", .offset = offsetof(struct memory_stat, kernel_stack) };
+    for (int i = 0; i < nr_keys; i++)
+        fields[2 + i] = (struct stat_field){
+            .key = keys[i], .offset = offsetof(struct memory_stat, extra) + i * sizeof(u64),
+        };
+    return 2 + nr_keys;
+}
+
+/*
+    Acceso a los archivos de cgroupfs: el módulo usa filp_open/kernel_read y
+    el benchmark open/read, así los dos recorren el mismo código de lectura.
+    error recibe la ruta de un archivo que no se pudo abrir, leer o parsear
+*/
+struct cgroup_file_ops {
+    int (*open)(const char *path, void **file);             // 0 o -errno
+    ssize_t (*read)(void *file, char *buf, size_t len, loff_t *pos);
+    void (*close)(void *file);
+    void (*error)(const char *path, int err);
+};
+
+// Buffers de trabajo de la lectura; nunca se usan desde dos contextos a la vez
+struct cgroup_reader {
+    const struct cgroup_file_ops *ops;
+    char *path;                         // PATH_MAX bytes
+    char *buf;                          // Bloque de lectura
+    size_t buf_size;
+    struct io_stat *io;                 // Demasiado grande para la pila del sampler
+};
+
+/*
+    Lector de archivos de estadísticas de cgroupfs: lee el archivo completo
+    por bloques en rd->buf y entrega cada línea a parse_line en una sola
+    pasada (stat_line_reader), sin importar el tamaño del archivo
+*/
+static inline int cgroup_stat_read(const struct cgroup_reader *rd, const char *cgroup_dir, const char *file,
+                                   void (*parse_line)(char *line, void *ctx), void *ctx) {
+    struct stat_line_reader r;
+    loff_t pos = 0;
+    void *filp;
+    ssize_t n;
+    size_t len;
+    char *dst;
+    int ret;
+
+    snprintf(rd->path, PATH_MAX, "%s/%s", cgroup_dir, file);
+    ret = rd->ops->open(rd->path, &filp);
+    if (ret) {
+        // Sin printk: un archivo que falta (p. ej. un controlador desactivado) fallaría en cada pasada
+        rd->ops->error(rd->path, ret);
+        return ret;
+    }
+
+    stat_lines_init(&r, rd->buf, rd->buf_size, parse_line, ctx);
+    for (;;) {
+        dst = stat_lines_space(&r, &len);
+        n = rd->ops->read(filp, dst, len, &pos);
+        if (n <= 0)
+            break;
+        stat_lines_feed(&r, n);
+    }
+    if (n == 0)
+        stat_lines_finish(&r);
+    if (n < 0)
+        rd->ops->error(rd->path, n);
+
+    rd->ops->close(filp);
+    return n < 0 ? n : 0;
+}
+
+static inline int flat_stat_read(const struct cgroup_reader *rd, const char *cgroup_dir, const char *file,
+                                 const struct stat_field *fields, int nr_fields, void *dst) {
+    struct flat_stat_ctx flat = { .fields = fields, .nr_fields = nr_fields, .dst = dst };
+
+    return cgroup_stat_read(rd, cgroup_dir, file, flat_stat_parse_line, &flat);
+}
+
+// memory.current está en bytes y cabe en una sola lectura; se devuelve en KB
+static inline unsigned long get_memory_usage(const struct cgroup_reader *rd, const char *cgroup_dir) {
+    void *filp;
+    loff_t pos = 0;
+    ssize_t n;
+    u64 mem_usage = 0;
+    int ret;
+
+    snprintf(rd->path, PATH_MAX, "%s/memory.current", cgroup_dir);
+    ret = rd->ops->open(rd->path, &filp);
+    if (ret) {
+        rd->ops->error(rd->path, ret);
+        return 0;
+    }
+
+    n = rd->ops->read(filp, rd->buf, rd->buf_size < 128 ? rd->buf_size - 1 : 127, &pos);
+    if (n > 0) {
+        rd->buf[n] = '\0';
+        ret = kstrtou64(rd->buf, 10, &mem_usage);
+        if (ret < 0) {
+            rd->ops->error(rd->path, ret);
+            mem_usage = 0;
+        }
+    } else {
+        rd->ops->error(rd->path, n ?: -ENODATA);
+    }
+
+    rd->ops->close(filp);
+    return mem_usage / 1024;
+}
+
+// usage_usec en microsegundos; los contadores de throttling solo existen si el controlador cpu está activo
+static inline void get_cpu_stat(const struct cgroup_reader *rd, const char *cgroup_dir, struct cpu_stat *cs) {
+    memset(cs, 0, sizeof(*cs));
+    flat_stat_read(rd, cgroup_dir, "cpu.stat", cpu_stat_fields, ARRAY_SIZE(cpu_stat_fields), cs);
+}
+
+static inline void get_memory_stats(const struct cgroup_reader *rd, const char *cgroup_dir,
+                                    const struct stat_field *fields, int nr_fields, struct memory_stat *ms) {
+    memset(ms, 0, sizeof(*ms));
+    flat_stat_read(rd, cgroup_dir, "memory.stat", fields, nr_fields, ms);
+}
+
+static inline void get_pressure_stats(const struct cgroup_reader *rd, const char *cgroup_dir,
+                                      struct psi_resource_stat *psi) {
+    memset(psi, 0, NR_SYSINFO_PSI * sizeof(*psi));
+    for (int i = 0; i < NR_SYSINFO_PSI; i++)
+        cgroup_stat_read(rd, cgroup_dir, psi_files[i], psi_parse_line, &psi[i]);
+}
+
+static inline void get_io_stats(const struct cgroup_reader *rd, const char *cgroup_dir, struct io_stat *st) {
+    memset(st, 0, sizeof(*st));
+    cgroup_stat_read(rd, cgroup_dir, "io.stat", io_stat_parse_line, st);
+}
+
+static inline void sysinfo_sample_cpu_stat(struct container_sample *sample, const struct cpu_stat *cs) {
+    sample->cpu_usage_usec = cs->usage_usec;
+    sample->nr_periods = cs->nr_periods;
+    sample->nr_throttled = cs->nr_throttled;
+    sample->throttled_usec = cs->throttled_usec;
+}
+
+// Qué archivos opcionales se leen de cada contenedor
+struct sysinfo_collect_opts {
+    bool pressure;
+    int nr_memory_stat_keys;
+    const struct stat_field *memory_stat_fields;
+    int nr_memory_stat_fields;
+};
+
+/*
+    Todo lo que se lee de cgroupfs después de CPU y memory.current (que el
+    módulo puede tomar sin abrir archivos): memory.stat, *.pressure e io.stat.
+    Los contenedores con --hdd usan kernel + kernel_stack de memory.stat en
+    lugar de mem_usage_kb
+*/
+static inline void sysinfo_collect_files(const struct cgroup_reader *rd, const char *cgroup_dir,
+                                         struct container_sample *sample, unsigned long mem_usage_kb,
+                                         const struct sysinfo_collect_opts *opts) {
+    bool hdd = strstr(sample->cmdline, "--hdd");
+    struct io_stat *io = rd->io;
+    struct memory_stat ms;
+
+    if (opts->nr_memory_stat_keys || hdd) {
+        get_memory_stats(rd, cgroup_dir, opts->memory_stat_fields, opts->nr_memory_stat_fields, &ms);
+        memcpy(sample->memory_stat, ms.extra, sizeof(sample->memory_stat));
+        if (hdd)
+            mem_usage_kb = (ms.kernel + ms.kernel_stack) / 1024;
+    }
+    sample->mem_usage_kb = mem_usage_kb;
+
+    if (opts->pressure)
+        get_pressure_stats(rd, cgroup_dir, sample->psi);
+
+    get_io_stats(rd, cgroup_dir, io);
+    sample->read_kb = io->total.rbytes / 1024;
+    sample->write_kb = io->total.wbytes / 1024;
+    sample->io_read_ops = io->total.rios;
+    sample->io_write_ops = io->total.wios;
+    sample->nr_io_devices = io->nr_devices < IO_MAX_DEVICES ? io->nr_devices : IO_MAX_DEVICES;
+    memcpy(sample->io_devices, io->devices, sample->nr_io_devices * sizeof(io->devices[0]));
+}
+
+/*
+    Secciones opcionales del JSON de cada contenedor. En el módulo salen de
+    los parámetros en cada lectura, por eso se pasan y no se leen globales
+*/
+struct sysinfo_show_opts {
+    bool throttling;
+    bool pressure;
+    bool io_devices;
+    int nr_memory_stat_keys;
+    char *const *memory_stat_keys;
+    int nr_stats_windows;
+    const unsigned int *stats_windows;
+};
+
+// Las métricas de CPU se guardan en centésimas de porcentaje, se muestran con dos decimales
+#define PCT(v) (v) / 100, (v) % 100
+
+static inline void sysinfo_show_metric(struct seq_file *m, const char *name, const struct metric_stats *s,
+                                       bool percent, const char *end) {
+    if (percent)
+        seq_printf(m, "\"%s\": { \"Min\": %u.%02u, \"Max\": %u.%02u, \"Mean\": %u.%02u, \"P95\": %u.%02u }%s",
+                   name, PCT(s->min), PCT(s->max), PCT(s->mean), PCT(s->p95), end);
+    else
+        seq_printf(m, "\"%s\": { \"Min\": %u, \"Max\": %u, \"Mean\": %u, \"P95\": %u }%s",
+                   name, s->min, s->max, s->mean, s->p95, end);
+}
+
+// Una entrada por ventana, con nombre "10s", "60s", ...
+static inline void sysinfo_show_stats(struct seq_file *m, const struct container_sample *c,
+                                      const struct sysinfo_show_opts *opts) {
+    seq_printf(m, ",\n      \"Stats\": {\n");
+    for (int w = 0; w < opts->nr_stats_windows; w++) {
+        const struct window_stats *ws = &c->stats[w];
+
+        seq_printf(m, "        \"%us\": {\n", opts->stats_windows[w]);
+        seq_printf(m, "          \"Samples\": %u,\n", ws->samples);
+        seq_printf(m, "          ");
+        sysinfo_show_metric(m, "CPUUsage_percent", &ws->m[STAT_CPU], true, ",\n          ");
+        sysinfo_show_metric(m, "MemoryUsage_KB", &ws->m[STAT_MEM], false, ",\n          ");
+        sysinfo_show_metric(m, "IOPS", &ws->m[STAT_IOPS], false, "\n");
+        seq_printf(m, "        }%s\n", w + 1 < opts->nr_stats_windows ? "," : "");
+    }
+    seq_printf(m, "      }");
+}
+
+static inline void sysinfo_show_throttling(struct seq_file *m, const struct container_sample *c) {
+    seq_printf(m, ",\n      \"CPUThrottling\": { \"NrPeriods\": %llu, \"NrThrottled\": %llu, \"Throttled_usec\": %llu }",
+               c->nr_periods, c->nr_throttled, c->throttled_usec);
+}
+
+static inline void sysinfo_show_psi(struct seq_file *m, const char *name, const struct psi_stat *ps,
+                                    const char *end) {
+    seq_printf(m, "\"%s\": { \"Avg10\": %llu.%02llu, \"Avg60\": %llu.%02llu, \"Total_usec\": %llu }%s",
+               name, ps->avg10 / 100, ps->avg10 % 100, ps->avg60 / 100, ps->avg60 % 100, ps->total, end);
+}
+
+static inline void sysinfo_show_pressure(struct seq_file *m, const struct container_sample *c) {
+    static const char *const names[NR_SYSINFO_PSI] = {
+        [SYSINFO_PSI_CPU] = "CPU",
+        [SYSINFO_PSI_MEMORY] = "Memory",
+        [SYSINFO_PSI_IO] = "IO",
+    };
+
+    seq_printf(m, ",\n      \"Pressure\": {\n");
+    for (int i = 0; i < NR_SYSINFO_PSI; i++) {
+        seq_printf(m, "        \"%s\": { ", names[i]);
+        sysinfo_show_psi(m, "Some", &c->psi[i].some, ", ");
+        sysinfo_show_psi(m, "Full", &c->psi[i].full, " }");
+        seq_printf(m, "%s\n", i + 1 < NR_SYSINFO_PSI ? "," : "");
+    }
+    seq_printf(m, "      }");
+}
+
+static inline void sysinfo_show_memory_stat(struct seq_file *m, const struct container_sample *c,
+                                            const struct sysinfo_show_opts *opts) {
+    seq_printf(m, ",\n      \"MemoryStat\": {");
+    for (int i = 0; i < opts->nr_memory_stat_keys; i++)
+        seq_printf(m, "%s \"%s\": %llu", i ? "," : "", opts->memory_stat_keys[i], c->memory_stat[i]);
+    seq_printf(m, " }");
+}
+
+static inline void sysinfo_show_io_devices(struct seq_file *m, const struct container_sample *c) {
+    seq_printf(m, ",\n      \"IODevices\": [");
+    for (unsigned int i = 0; i < c->nr_io_devices; i++) {
+        const struct io_device_stat *d = &c->io_devices[i];
+
+        seq_printf(m, "%s\n        { \"Device\": \"%u:%u\", \"Read_KBytes\": %llu, \"Write_KBytes\": %llu, "
+                   "\"IOReadOps\": %llu, \"IOWriteOps\": %llu }",
+                   i ? "," : "", d->major, d->minor, d->rbytes / 1024, d->wbytes / 1024, d->rios, d->wios);
+    }
+    seq_printf(m, "%s]", c->nr_io_devices ? "\n      " : "");
+}
+
+static inline void sysinfo_show_container(struct seq_file *m, const struct container_sample *c, int first,
+                                          const char *change, const struct sysinfo_show_opts *opts) {
+    // Calcular MemoryUsage_MB con decimales
+    unsigned long mem_usage_mb_whole = c->mem_usage_kb / 1024; // Parte entera (MB)
+    unsigned long mem_usage_mb_frac = ((c->mem_usage_kb % 1024) * 100) / 1024; // Parte fraccional (2 dígitos)
+
+    // Calcular DiskUse_MB con decimales
+    unsigned long disk_usage_kb = c->write_kb + c->read_kb; // Total en KB
+    unsigned long disk_usage_mb_whole = disk_usage_kb / 1024; // Parte entera (MB)
+    unsigned long disk_usage_mb_frac = ((disk_usage_kb % 1024) * 100) / 1024; // Parte fraccional (2 dígitos)
+
+    if (!first)
+        seq_printf(m, ",\n");
+
+    seq_printf(m, "    {\n");
+    if (change)
+        seq_printf(m, "      \"Change\": \"%s\",\n", change);
+    seq_printf(m, "      \"PID\": %d,\n", c->pid);
+    seq_printf(m, "      \"Name\": \"%s\",\n", c->comm);
+    seq_printf(m, "      \"ContainerID\": \"%.12s\",\n", c->id);
+    seq_printf(m, "      \"Cmdline\": \"%s\",\n", c->cmdline);
+    seq_printf(m, "      \"MemoryUsage_percent\": %lu.%02lu,\n", c->mem_percentage / 100, c->mem_percentage % 100);
+    seq_printf(m, "      \"MemoryUsage_MB\": %lu.%02lu,\n", mem_usage_mb_whole, mem_usage_mb_frac);
+    seq_printf(m, "      \"CPUUsage_percent\": %lu.%02lu,\n", c->cpu_percentage / 100, c->cpu_percentage % 100);
+    seq_printf(m, "      \"DiskUse_MB\": %lu.%02lu,\n", disk_usage_mb_whole, disk_usage_mb_frac);
+    seq_printf(m, "      \"Write_KBytes\": %lu,\n", c->write_kb);
+    seq_printf(m, "      \"Read_KBytes\": %lu,\n", c->read_kb);
+    seq_printf(m, "      \"IOReadOps\": %lu,\n", c->io_read_ops);
+    seq_printf(m, "      \"IOWriteOps\": %lu", c->io_write_ops);
+
+    // Secciones opcionales, cada una empieza con la coma del campo anterior
+    if (opts->throttling)
+        sysinfo_show_throttling(m, c);
+    if (opts->pressure)
+        sysinfo_show_pressure(m, c);
+    if (opts->nr_memory_stat_keys)
+        sysinfo_show_memory_stat(m, c, opts);
+    if (opts->io_devices)
+        sysinfo_show_io_devices(m, c);
+    if (opts->nr_stats_windows)
+        sysinfo_show_stats(m, c, opts);
+
+    seq_printf(m, "\n    }");
+}
+
+#endif /* _SYSINFO_202202906_CORE_H */
@@ -0,0 +1,186 @@
+/*
+    Pruebas KUnit de sysinfo_202202906_core.h: parsers de los archivos de
+    estadísticas de cgroupfs y formato JSON de un contenedor. Se compila
+    módulo aparte cuando el kernel tiene CONFIG_KUNIT; los resultados salen
+    en dmesg y en /sys/kernel/debug/kunit/sysinfo_202202906_core/results:
+      make && insmod sysinfo_202202906_kunit.ko
+*/
+#include <kunit/test.h>
+#include <linux/module.h>
+#include <linux/string.h>
+
+#include "sysinfo_202202906_core.h"
+
+static void test_kstrtocenti(struct kunit *test) {
+    char ok[] = "12.34", whole[] = "7", one_digit[] = "1.5", junk[] = "1.2x";
+    u64 v;
+
+    KUNIT_EXPECT_EQ(test, kstrtocenti(ok, &v), 0);
+    KUNIT_EXPECT_EQ(test, v, 1234ULL);
+    KUNIT_EXPECT_EQ(test, kstrtocenti(whole, &v), 0);
+    KUNIT_EXPECT_EQ(test, v, 700ULL);
+    KUNIT_EXPECT_LT(test, kstrtocenti(one_digit, &v), 0);
+    KUNIT_EXPECT_LT(test, kstrtocenti(junk, &v), 0);
+}
+
+static void test_cpu_stat(struct kunit *test) {
+    char lines[][32] = { "usage_usec 1500", "user_usec 900", "nr_periods 40", "nr_throttled 3",
+                         "throttled_usec 12000", "nr_bursts 0", "bogus" };
+    struct cpu_stat cs = {};
+    struct flat_stat_ctx flat = { cpu_stat_fields, ARRAY_SIZE(cpu_stat_fields), &cs };
+
+    for (int i = 0; i < ARRAY_SIZE(lines); i++)
+        flat_stat_parse_line(lines[i], &flat);
+
+    KUNIT_EXPECT_EQ(test, cs.usage_usec, 1500ULL);
+    KUNIT_EXPECT_EQ(test, cs.nr_periods, 40ULL);
+    KUNIT_EXPECT_EQ(test, cs.nr_throttled, 3ULL);
+    KUNIT_EXPECT_EQ(test, cs.throttled_usec, 12000ULL);
+}
+
+static void test_psi(struct kunit *test) {
+    char some[] = "some avg10=1.25 avg60=0.50 avg300=0.10 total=123456";
+    char full[] = "full avg10=0.05 avg60=10.00 avg300=0.00 total=42";
+    struct psi_resource_stat res = {};
+
+    psi_parse_line(some, &res);
+    psi_parse_line(full, &res);
+
+    KUNIT_EXPECT_EQ(test, res.some.avg10, 125ULL);
+    KUNIT_EXPECT_EQ(test, res.some.avg60, 50ULL);
+    KUNIT_EXPECT_EQ(test, res.some.total, 123456ULL);
+    KUNIT_EXPECT_EQ(test, res.full.avg10, 5ULL);
+    KUNIT_EXPECT_EQ(test, res.full.avg60, 1000ULL);
+    KUNIT_EXPECT_EQ(test, res.full.total, 42ULL);
+}
+
+// Con más dispositivos que IO_MAX_DEVICES el total los suma todos y el detalle guarda los primeros
+static void test_io_stat(struct kunit *test) {
+    struct io_stat *st = kunit_kzalloc(test, sizeof(*st), GFP_KERNEL);
+    char line[96];
+
+    KUNIT_ASSERT_NOT_NULL(test, st);
+    for (int i = 0; i < IO_MAX_DEVICES + 2; i++) {
+        snprintf(line, sizeof(line), "8:%d rbytes=1024 wbytes=2048 rios=1 wios=2 dbytes=0 dios=0", i * 16);
+        io_stat_parse_line(line, st);
+    }
+
+    KUNIT_EXPECT_EQ(test, st->nr_devices, IO_MAX_DEVICES + 2);
+    KUNIT_EXPECT_EQ(test, st->total.rbytes, 1024ULL * (IO_MAX_DEVICES + 2));
+    KUNIT_EXPECT_EQ(test, st->total.wios, 2ULL * (IO_MAX_DEVICES + 2));
+    KUNIT_EXPECT_EQ(test, st->devices[1].major, 8U);
+    KUNIT_EXPECT_EQ(test, st->devices[1].minor, 16U);
+}
+
+struct line_log {
+    int count;
+    char last[32];
+};
+
+static void log_line(char *line, void *ctx) {
+    struct line_log *log = ctx;
+
+    log->count++;
+    strscpy(log->last, line, sizeof(log->last));
+}
+
+static void feed(struct stat_line_reader *r, const char *text, size_t chunk) {
+    size_t len, n;
+    char *dst;
+
+    while (*text) {
+        dst = stat_lines_space(r, &len);
+        n = min3(len, chunk, strlen(text));
+        memcpy(dst, text, n);
+        stat_lines_feed(r, n);
+        text += n;
+    }
+    stat_lines_finish(r);
+}
+
+// Las líneas que quedan partidas entre bloques se entregan completas y una sola vez
+static void test_line_reader_split(struct kunit *test) {
+    struct stat_line_reader r;
+    struct line_log log = {};
+    char buf[16];
+
+    stat_lines_init(&r, buf, sizeof(buf), log_line, &log);
+    feed(&r, "anon 1\nfile 22\nkernel 333\nshmem 4444", 5);
+
+    KUNIT_EXPECT_EQ(test, log.count, 4);
+    KUNIT_EXPECT_STREQ(test, log.last, "shmem 4444");
+}
+
+static void test_line_reader_long_line(struct kunit *test) {
+    struct stat_line_reader r;
+    struct line_log log = {};
+    char buf[8];
+
+    stat_lines_init(&r, buf, sizeof(buf), log_line, &log);
+    feed(&r, "a 1\nmuy_larga 123456789\nb 2\n", 3);
+
+    KUNIT_EXPECT_EQ(test, log.count, 2);
+    KUNIT_EXPECT_STREQ(test, log.last, "b 2");
+}
+
+static void test_show_container(struct kunit *test) {
+    static char *keys[] = { "file" };
+    static const unsigned int windows[] = { 10 };
+    struct sysinfo_show_opts opts = {
+        .pressure = true,
+        .nr_memory_stat_keys = 1,
+        .memory_stat_keys = keys,
+        .nr_stats_windows = 1,
+        .stats_windows = windows,
+    };
+    struct container_sample *c = kunit_kzalloc(test, sizeof(*c), GFP_KERNEL);
+    struct seq_file m = { .size = PAGE_SIZE };
+
+    KUNIT_ASSERT_NOT_NULL(test, c);
+    m.buf = kunit_kzalloc(test, m.size, GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, m.buf);
+
+    strscpy(c->id, "0123456789abcdef", sizeof(c->id));
+    strscpy(c->comm, "stress", sizeof(c->comm));
+    c->pid = 42;
+    c->cpu_percentage = 1234;
+    c->mem_usage_kb = 1536;
+    c->memory_stat[0] = 77;
+    c->psi[SYSINFO_PSI_IO].full.avg10 = 305;
+    c->stats[0].samples = 9;
+
+    sysinfo_show_container(&m, c, 1, "added", &opts);
+    KUNIT_ASSERT_FALSE(test, seq_has_overflowed(&m));
+    m.buf[m.count] = '\0';
+
+    KUNIT_EXPECT_TRUE(test, str_has_prefix(m.buf, "    {\n      \"Change\": \"added\",\n"));
+    KUNIT_EXPECT_NOT_NULL(test, strstr(m.buf, "\"ContainerID\": \"0123456789ab\","));
+    KUNIT_EXPECT_NOT_NULL(test, strstr(m.buf, "\"MemoryUsage_MB\": 1.50,"));
+    KUNIT_EXPECT_NOT_NULL(test, strstr(m.buf, "\"CPUUsage_percent\": 12.34,"));
+    KUNIT_EXPECT_NOT_NULL(test, strstr(m.buf, "\"Full\": { \"Avg10\": 3.05,"));
+    KUNIT_EXPECT_NOT_NULL(test, strstr(m.buf, "\"MemoryStat\": { \"file\": 77 }"));
+    KUNIT_EXPECT_NOT_NULL(test, strstr(m.buf, "\"10s\": {\n          \"Samples\": 9,"));
+    KUNIT_EXPECT_NULL(test, strstr(m.buf, "CPUThrottling"));
+    KUNIT_EXPECT_NULL(test, strstr(m.buf, "IODevices"));
+    KUNIT_EXPECT_STREQ(test, m.buf + m.count - strlen("\n    }"), "\n    }");
+}
+
+static struct kunit_case sysinfo_core_cases[] = {
+    KUNIT_CASE(test_kstrtocenti),
+    KUNIT_CASE(test_cpu_stat),
+    KUNIT_CASE(test_psi),
+    KUNIT_CASE(test_io_stat),
+    KUNIT_CASE(test_line_reader_split),
+    KUNIT_CASE(test_line_reader_long_line),
+    KUNIT_CASE(test_show_container),
+    {}
+};
+
+static struct kunit_suite sysinfo_core_suite = {
+    .name = "sysinfo_202202906_core",
+    .test_cases = sysinfo_core_cases,
+};
+kunit_test_suite(sysinfo_core_suite);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Pruebas KUnit del núcleo de sysinfo_202202906");
@@ -0,0 +1,183 @@
+/*
+    Tracepoints estáticos del módulo sysinfo_202202906 para perfilar el costo
+    de cada pasada con perf o ftrace, por ejemplo:
+      perf record -e 'sysinfo_202202906:*' -a
+      echo 1 > /sys/kernel/tracing/events/sysinfo_202202906/enable
+    Solo sysinfo_202202906.c define CREATE_TRACE_POINTS antes de incluirlo
+*/
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM sysinfo_202202906
+
+#if !defined(_SYSINFO_202202906_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _SYSINFO_202202906_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <linux/version.h>
+
+// Fases de una pasada del sampler, en el orden en que se ejecutan
+#ifndef SYSINFO_TRACE_PHASES_ONCE
+#define SYSINFO_TRACE_PHASES_ONCE
+enum sysinfo_phase {
+    SYSINFO_PHASE_DISCOVERY,
+    SYSINFO_PHASE_SWEEP,
+    SYSINFO_PHASE_HOST,
+    SYSINFO_PHASE_CONTAINERS,
+    SYSINFO_PHASE_PUBLISH,
+};
+
+// Desde 6.10 __assign_str toma el origen de __string()
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 10, 0)
+#define sysinfo_assign_str(dst, src) __assign_str(dst)
+#else
+#define sysinfo_assign_str(dst, src) __assign_str(dst, src)
+#endif
+#endif
+
+TRACE_DEFINE_ENUM(SYSINFO_PHASE_DISCOVERY);
+TRACE_DEFINE_ENUM(SYSINFO_PHASE_SWEEP);
+TRACE_DEFINE_ENUM(SYSINFO_PHASE_HOST);
+TRACE_DEFINE_ENUM(SYSINFO_PHASE_CONTAINERS);
+TRACE_DEFINE_ENUM(SYSINFO_PHASE_PUBLISH);
+
+#define show_sysinfo_phase(phase)                                   \
+    __print_symbolic(phase,                                         \
+                     { SYSINFO_PHASE_DISCOVERY, "discovery" },      \
+                     { SYSINFO_PHASE_SWEEP, "sweep" },              \
+                     { SYSINFO_PHASE_HOST, "host" },                \
+                     { SYSINFO_PHASE_CONTAINERS, "containers" },    \
+                     { SYSINFO_PHASE_PUBLISH, "publish" })
+
+TRACE_EVENT(sysinfo_phase_start,
+
+    TP_PROTO(u64 gen, unsigned int phase),
+
+    TP_ARGS(gen, phase),
+
+    TP_STRUCT__entry(
+        __field(u64, gen)
+        __field(unsigned int, phase)
+    ),
+
+    TP_fast_assign(
+        __entry->gen = gen;
+        __entry->phase = phase;
+    ),
+
+    TP_printk("gen=%llu phase=%s", __entry->gen, show_sysinfo_phase(__entry->phase))
+);
+
+// count depende de la fase: contenedores vistos, dados de baja, muestreados o publicados
+TRACE_EVENT(sysinfo_phase_end,
+
+    TP_PROTO(u64 gen, unsigned int phase, unsigned int count, u64 duration_ns),
+
+    TP_ARGS(gen, phase, count, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(u64, gen)
+        __field(unsigned int, phase)
+        __field(unsigned int, count)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->gen = gen;
+        __entry->phase = phase;
+        __entry->count = count;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk("gen=%llu phase=%s count=%u duration_ns=%llu", __entry->gen,
+              show_sysinfo_phase(__entry->phase), __entry->count, __entry->duration_ns)
+);
+
+TRACE_EVENT(sysinfo_container_collect,
+
+    TP_PROTO(const char *id, pid_t pid, u64 duration_ns),
+
+    TP_ARGS(id, pid, duration_ns),
+
+    TP_STRUCT__entry(
+        __string(id, id)
+        __field(pid_t, pid)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        sysinfo_assign_str(id, id);
+        __entry->pid = pid;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk("id=%s pid=%d duration_ns=%llu", __get_str(id), __entry->pid, __entry->duration_ns)
+);
+
+// Un evento de alta o baja procesado por lifecycle_work; id queda vacío si no era de un contenedor
+TRACE_EVENT(sysinfo_container_lifecycle,
+
+    TP_PROTO(const char *event, const char *id, pid_t pid),
+
+    TP_ARGS(event, id, pid),
+
+    TP_STRUCT__entry(
+        __string(event, event)
+        __string(id, id)
+        __field(pid_t, pid)
+    ),
+
+    TP_fast_assign(
+        sysinfo_assign_str(event, event);
+        sysinfo_assign_str(id, id);
+        __entry->pid = pid;
+    ),
+
+    TP_printk("event=%s id=%s pid=%d", __get_str(event), __get_str(id), __entry->pid)
+);
+
+// Reemplaza los printk que se emitían por cada archivo de cgroupfs que no se pudo leer
+TRACE_EVENT(sysinfo_cgroup_read_error,
+
+    TP_PROTO(const char *path, int err),
+
+    TP_ARGS(path, err),
+
+    TP_STRUCT__entry(
+        __string(path, path)
+        __field(int, err)
+    ),
+
+    TP_fast_assign(
+        sysinfo_assign_str(path, path);
+        __entry->err = err;
+    ),
+
+    TP_printk("path=%s err=%d", __get_str(path), __entry->err)
+);
+
+// Una lectura completa de /proc/sysinfo_202202906, sumando todas las llamadas a read()
+TRACE_EVENT(sysinfo_show,
+
+    TP_PROTO(unsigned int nr_containers, u64 duration_ns),
+
+    TP_ARGS(nr_containers, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, nr_containers)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->nr_containers = nr_containers;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk("nr_containers=%u duration_ns=%llu", __entry->nr_containers, __entry->duration_ns)
+);
+
+#endif /* _SYSINFO_202202906_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE sysinfo_202202906_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,93 @@
+"""
+Historial acotado de métricas para las gráficas en vivo.
+
+Cada serie guarda sus muestras en tres resoluciones, cada una en un deque de
+tamaño fijo: las últimas muestras tal como llegan, promedios por minuto y
+promedios por 10 minutos. Al graficar se usa la resolución más fina que
+cubre cada tramo de tiempo, así la memoria y la cantidad de puntos que se
+dibujan no crecen con el tiempo que lleva corriendo el servicio.
+"""
+import threading
+from collections import deque
+from datetime import datetime, timezone
+
+RAW_POINTS = 360        # 1 hora con muestras cada 10 s
+MINUTE_POINTS = 360     # 6 horas en cubetas de 1 minuto
+TEN_MINUTE_POINTS = 432  # 3 días en cubetas de 10 minutos
+
+
+class BucketTier:
+    """Promedios por cubetas de width segundos; la cubeta abierta se muestra parcial"""
+
+    def __init__(self, width, points):
+        self.width = width
+        self.closed = deque(maxlen=points)  # (inicio de la cubeta, promedios)
+        self.start = None
+        self.sums = None
+        self.count = 0
+
+    def add(self, ts, values):
+        start = int(ts // self.width) * self.width
+        if self.start is not None and start != self.start:
+            self.closed.append(self._current())
+            self.start = None
+        if self.start is None:
+            self.start = start
+            self.sums = [0.0] * len(values)
+            self.count = 0
+        for i, v in enumerate(values):
+            self.sums[i] += v
+        self.count += 1
+
+    def _current(self):
+        return (self.start, tuple(s / self.count for s in self.sums))
+
+    def points(self):
+        pts = list(self.closed)
+        if self.start is not None:
+            pts.append(self._current())
+        return pts
+
+
+class MetricSeries:
+    def __init__(self, metrics):
+        self.metrics = list(metrics)
+        self.lock = threading.Lock()
+        self.raw = deque(maxlen=RAW_POINTS)  # (ts en segundos, valores)
+        # De la más fina a la más gruesa
+        self.tiers = [BucketTier(60, MINUTE_POINTS), BucketTier(600, TEN_MINUTE_POINTS)]
+
+    def __len__(self):
+        return len(self.raw)
+
+    def append(self, timestamp, values):
+        ts = timestamp.timestamp()
+        values = tuple(float(v) for v in values)
+        with self.lock:
+            self.raw.append((ts, values))
+            for tier in self.tiers:
+                tier.add(ts, values)
+
+    def last(self, metric):
+        with self.lock:
+            return self.raw[-1][1][self.metrics.index(metric)] if self.raw else None
+
+    def points(self):
+        """
+        Devuelve (timestamps, {métrica: valores}) de la más vieja a la más
+        nueva. Una cubeta solo entra si termina antes del primer punto de la
+        resolución más fina, así ningún tramo se dibuja dos veces
+        """
+        with self.lock:
+            merged = list(self.raw)
+            tiers = [(tier.width, tier.points()) for tier in self.tiers]
+
+        for width, pts in tiers:
+            if merged:
+                boundary = merged[0][0]
+                pts = [p for p in pts if p[0] + width <= boundary]
+            merged = pts + merged
+
+        timestamps = [datetime.fromtimestamp(ts, tz=timezone.utc) for ts, _ in merged]
+        columns = {m: [values[i] for _, values in merged] for i, m in enumerate(self.metrics)}
+        return timestamps, columns
@@ -0,0 +1,271 @@
+"""
+Almacén de logs en segmentos NDJSON de solo escritura al final.
+
+Cada log es una línea JSON en el segmento activo (segment-<n>.ndjson). Junto
+a cada segmento hay un índice (segment-<n>.idx) con una línea "ts_ms fin" por
+log: la marca de tiempo en milisegundos y el byte donde termina ese log. Al
+pasar de max_bytes el segmento se cierra, se escribe su resumen
+(segment-<n>.meta: primera y última marca, cantidad y si está ordenado) y se
+abre el siguiente. Así agregar un log cuesta lo mismo sin importar cuánta
+historia haya, y una consulta por rango solo abre los segmentos que se cruzan
+con el rango y salta con búsqueda binaria al primer log que le toca.
+"""
+import bisect
+import json
+import os
+import threading
+from pathlib import Path
+
+READ_CHUNK = 64 * 1024
+
+
+class Segment:
+    def __init__(self, path):
+        self.path = path
+        self.index_path = path.with_suffix(".idx")
+        self.meta_path = path.with_suffix(".meta")
+        self.count = 0
+        self.min_ts = None
+        self.max_ts = None
+        self.sorted = True  # Marcas no decrecientes: el rango de una consulta es contiguo
+        self.size = 0
+
+    @property
+    def seq(self):
+        return int(self.path.stem.split("-")[1])
+
+    def overlaps(self, start_ms, end_ms):
+        if self.count == 0:
+            return False
+        return (start_ms is None or self.max_ts >= start_ms) and (end_ms is None or self.min_ts <= end_ms)
+
+    def add(self, ts_ms, end):
+        if self.count == 0:
+            self.min_ts = self.max_ts = ts_ms
+        else:
+            if ts_ms < self.max_ts:
+                self.sorted = False
+            self.min_ts = min(self.min_ts, ts_ms)
+            self.max_ts = max(self.max_ts, ts_ms)
+        self.count += 1
+        self.size = end
+
+    def load_index(self):
+        timestamps, ends = [], []
+        if self.index_path.exists():
+            with open(self.index_path, "r") as f:
+                for line in f:
+                    parts = line.split()
+                    if not line.endswith("\n") or len(parts) != 2:
+                        break  # Línea incompleta de una escritura interrumpida
+                    timestamps.append(int(parts[0]))
+                    ends.append(int(parts[1]))
+        return timestamps, ends
+
+    def write_meta(self):
+        meta = {"count": self.count, "min_ts": self.min_ts, "max_ts": self.max_ts,
+                "sorted": self.sorted, "size": self.size}
+        tmp = self.meta_path.with_suffix(".meta.tmp")
+        with open(tmp, "w") as f:
+            json.dump(meta, f)
+        os.replace(tmp, self.meta_path)
+
+    def read_meta(self):
+        try:
+            with open(self.meta_path, "r") as f:
+                meta = json.load(f)
+        except (OSError, ValueError):
+            return False
+        self.count = meta["count"]
+        self.min_ts = meta["min_ts"]
+        self.max_ts = meta["max_ts"]
+        self.sorted = meta["sorted"]
+        self.size = meta["size"]
+        return True
+
+
+class LogStore:
+    def __init__(self, directory, max_bytes=64 * 1024 * 1024, max_segments=0):
+        self.directory = Path(directory)
+        self.max_bytes = max_bytes
+        self.max_segments = max_segments  # 0 conserva todos los segmentos
+        self.lock = threading.Lock()
+        self.segments = []
+        # Índice del segmento activo en memoria; los cerrados se leen del .idx al consultarlos
+        self.active_ts = []
+        self.active_ends = []
+        self.data_fd = None
+        self.index_fd = None
+        self._open()
+
+    # ---------------------------------------------------------------- apertura
+    def _open(self):
+        self.directory.mkdir(parents=True, exist_ok=True)
+        paths = sorted(self.directory.glob("segment-*.ndjson"), key=lambda p: int(p.stem.split("-")[1]))
+        for path in paths:
+            segment = Segment(path)
+            if not segment.read_meta():
+                self._recover(segment)
+                if path != paths[-1]:
+                    segment.write_meta()
+            self.segments.append(segment)
+
+        if not self.segments:
+            self.segments.append(Segment(self.directory / "segment-00000001.ndjson"))
+        active = self.segments[-1]
+        if active.meta_path.exists():
+            active = self._new_segment()
+        else:
+            self.active_ts, self.active_ends = active.load_index()
+        self._open_active(active)
+
+    def _recover(self, segment):
+        """
+        Reconstruye el resumen desde el índice. Un log cuya línea de índice no
+        alcanzó a escribirse se descarta: el archivo de datos se corta al final
+        del último log indexado
+        """
+        timestamps, ends = segment.load_index()
+        for ts_ms, end in zip(timestamps, ends):
+            segment.add(ts_ms, end)
+        if segment.path.exists() and segment.path.stat().st_size != segment.size:
+            os.truncate(segment.path, segment.size)
+        if segment.index_path.exists():
+            # Quita una línea de índice incompleta al final
+            with open(segment.index_path, "r+") as f:
+                f.truncate(sum(len(f"{t} {e}\n") for t, e in zip(timestamps, ends)))
+
+    def _new_segment(self):
+        seq = self.segments[-1].seq + 1 if self.segments else 1
+        segment = Segment(self.directory / f"segment-{seq:08d}.ndjson")
+        self.segments.append(segment)
+        self.active_ts, self.active_ends = [], []
+        return segment
+
+    def _open_active(self, segment):
+        flags = os.O_WRONLY | os.O_CREAT | os.O_APPEND
+        self.data_fd = os.open(segment.path, flags, 0o644)
+        self.index_fd = os.open(segment.index_path, flags, 0o644)
+
+    def _rotate(self):
+        os.close(self.data_fd)
+        os.close(self.index_fd)
+        self.segments[-1].write_meta()
+        self._open_active(self._new_segment())
+
+        while self.max_segments and len(self.segments) > self.max_segments:
+            old = self.segments.pop(0)
+            for path in (old.path, old.index_path, old.meta_path):
+                try:
+                    path.unlink()
+                except FileNotFoundError:
+                    pass
+
+    def close(self):
+        with self.lock:
+            if self.data_fd is not None:
+                os.close(self.data_fd)
+                os.close(self.index_fd)
+                self.data_fd = self.index_fd = None
+
+    # ---------------------------------------------------------------- escritura
+    def append(self, ts_ms, entry):
+        """Agrega un log (dict serializable) con su marca de tiempo en milisegundos"""
+        self.append_many([(ts_ms, entry)])
+
+    def append_many(self, items):
+        """
+        Agrega varios logs [(ts_ms, entry)] en orden. Se hace una sola escritura
+        de datos y una de índice por segmento, en vez de dos por log
+        """
+        lines = [(ts_ms, (json.dumps(entry, separators=(",", ":")) + "\n").encode()) for ts_ms, entry in items]
+        with self.lock:
+            pending = []  # (ts_ms, fin, línea) aún no escritos en el segmento activo
+            for ts_ms, line in lines:
+                segment = self.segments[-1]
+                size = pending[-1][1] if pending else segment.size
+                if (segment.count or pending) and size + len(line) > self.max_bytes:
+                    self._write_pending(pending)
+                    pending = []
+                    self._rotate()
+                    size = 0
+                pending.append((ts_ms, size + len(line), line))
+            self._write_pending(pending)
+
+    def _write_pending(self, pending):
+        if not pending:
+            return
+        segment = self.segments[-1]
+        # Primero los datos y después el índice: un log sin índice se descarta al reabrir
+        os.write(self.data_fd, b"".join(line for _, _, line in pending))
+        os.write(self.index_fd, "".join(f"{ts_ms} {end}\n" for ts_ms, end, _ in pending).encode())
+        for ts_ms, end, _ in pending:
+            segment.add(ts_ms, end)
+            self.active_ts.append(ts_ms)
+            self.active_ends.append(end)
+
+    # ---------------------------------------------------------------- lectura
+    def query(self, start_ms=None, end_ms=None, limit=None):
+        """
+        Genera los logs (bytes de la línea JSON, sin el salto de línea) con
+        marca en [start_ms, end_ms], en el orden en que llegaron. Trabaja sobre
+        una copia de los índices, así no bloquea las escrituras mientras lee
+        """
+        with self.lock:
+            segments = [s for s in self.segments if s.overlaps(start_ms, end_ms)]
+            active = self.segments[-1]
+            active_index = (list(self.active_ts), list(self.active_ends))
+
+        remaining = limit
+        for segment in segments:
+            if segment is active:
+                timestamps, ends = active_index
+            else:
+                timestamps, ends = segment.load_index()
+            try:
+                for line in self._query_segment(segment, timestamps, ends, start_ms, end_ms):
+                    if remaining is not None:
+                        if remaining <= 0:
+                            return
+                        remaining -= 1
+                    yield line
+            except FileNotFoundError:
+                continue  # La retención borró el segmento durante la consulta
+
+    def _query_segment(self, segment, timestamps, ends, start_ms, end_ms):
+        if not timestamps:
+            return
+        if segment.sorted:
+            first = bisect.bisect_left(timestamps, start_ms) if start_ms is not None else 0
+            last = bisect.bisect_right(timestamps, end_ms) if end_ms is not None else len(timestamps)
+            if first < last:
+                begin = ends[first - 1] if first else 0
+                yield from self._read_lines(segment.path, begin, ends[last - 1])
+            return
+
+        # Marcas fuera de orden: se revisa el índice completo y se lee cada log por separado
+        with open(segment.path, "rb") as f:
+            for i, ts_ms in enumerate(timestamps):
+                if (start_ms is not None and ts_ms < start_ms) or (end_ms is not None and ts_ms > end_ms):
+                    continue
+                begin = ends[i - 1] if i else 0
+                f.seek(begin)
+                yield f.read(ends[i] - begin).rstrip(b"\n")
+
+    @staticmethod
+    def _read_lines(path, begin, end):
+        """Lee [begin, end) por bloques y entrega una línea a la vez"""
+        with open(path, "rb") as f:
+            f.seek(begin)
+            pending = b""
+            left = end - begin
+            while left > 0:
+                chunk = f.read(min(READ_CHUNK, left))
+                if not chunk:
+                    break
+                left -= len(chunk)
+                lines = (pending + chunk).split(b"\n")
+                pending = lines.pop()
+                yield from lines
+            if pending:
+                yield pending
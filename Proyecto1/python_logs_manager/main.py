@@ -1,27 +1,53 @@
-from fastapi import FastAPI, HTTPException
+from fastapi import FastAPI, HTTPException, Request
+from fastapi.responses import StreamingResponse
+from starlette.concurrency import run_in_threadpool
+from typing import Optional
+import gzip
+import io
 import json
 import os
 from pathlib import Path
 import matplotlib.pyplot as plt
+import matplotlib.dates as mdates
 from pydantic import BaseModel
 import time
 from dateutil import parser
 import numpy as np
 import threading
+from log_store import LogStore
+from history import MetricSeries
 
 app = FastAPI()
 
-# 📂 Archivo JSON donde se guardarán los logs
-LOGS_FILE = Path("/app/logs/logs.json")
+# 📂 Directorio de los segmentos NDJSON donde se guardan los logs
+LOGS_DIR = Path("/app/logs/segments")
+# Archivo JSON de versiones anteriores, se importa una sola vez a los segmentos
+LEGACY_LOGS_FILE = Path("/app/logs/logs.json")
+SEGMENT_MAX_MB = int(os.environ.get("LOGS_SEGMENT_MAX_MB", "64"))
+MAX_SEGMENTS = int(os.environ.get("LOGS_MAX_SEGMENTS", "0"))  # 0 conserva toda la historia
 
-# Crear el directorio y el archivo si no existen
-def ensure_logs_file():
-    LOGS_FILE.parent.mkdir(parents=True, exist_ok=True)
-    if not LOGS_FILE.exists():
-        with open(LOGS_FILE, "w") as f:
-            json.dump([], f)
+# Marca de tiempo ISO 8601 a milisegundos desde la época, para el índice
+def timestamp_ms(timestamp):
+    return int(parser.isoparse(timestamp).timestamp() * 1000)
 
-ensure_logs_file()
+store = LogStore(LOGS_DIR, max_bytes=SEGMENT_MAX_MB * 1024 * 1024, max_segments=MAX_SEGMENTS)
+
+# Los logs de logs.json pasan a los segmentos y el archivo queda como logs.json.migrated
+def migrate_legacy_logs():
+    if not LEGACY_LOGS_FILE.exists():
+        return
+    try:
+        with open(LEGACY_LOGS_FILE, "r") as f:
+            logs = json.load(f) if LEGACY_LOGS_FILE.stat().st_size else []
+    except ValueError as e:
+        print(f"[WARN] No se pudo importar {LEGACY_LOGS_FILE}: {e}")
+        return
+    for log in logs:
+        store.append(timestamp_ms(log["timestamp"]), log)
+    LEGACY_LOGS_FILE.rename(LEGACY_LOGS_FILE.with_suffix(".json.migrated"))
+    print(f"[INFO] {len(logs)} logs importados de {LEGACY_LOGS_FILE}")
+
+migrate_legacy_logs()
 
 # 📌 Modelo de datos para los logs
 class LogEntry(BaseModel):
@@ -29,99 +55,164 @@ class LogEntry(BaseModel):
     sysinfo: dict
 
 # 📌 Variable global para almacenar datos históricos por ejecución (contenedores)
+# El historial es acotado (ver history.py), "latest" es la última muestra de la categoría
 categories = ["cpu", "ram", "io", "disk"]
-data_by_category = {
-    cat: {
-        "MemoryUsage_percent": [],
-        "CPUUsage_percent": [],
-        "timestamps": [],
-        "latest": None
-    } for cat in categories
-}
+CONTAINER_METRICS = ["MemoryUsage_percent", "CPUUsage_percent"]
+SYSTEM_METRICS = ["Free_Memory_MB", "Used_Memory_MB", "CPU_Usage_Percentage"]
+
+def new_category_data():
+    return {cat: {"series": MetricSeries(CONTAINER_METRICS), "latest": None} for cat in categories}
+
+data_by_category = new_category_data()
 
 # 📌 Variable global para almacenar datos del sistema por ejecución
-system_data = {
-    "Free_Memory_MB": [],
-    "Used_Memory_MB": [],
-    "CPU_Usage_Percentage": [],
-    "timestamps": []
-}
-
-# 📌 Endpoint para recibir logs desde Rust y almacenarlos en el JSON
+system_data = MetricSeries(SYSTEM_METRICS)
+
+# Se activa con cada log recibido; las gráficas solo se redibujan cuando hay datos nuevos
+new_data = threading.Event()
+RENDER_INTERVAL = 5  # Segundos mínimos entre dos redibujados
+
+# Actualiza el historial en memoria de las gráficas con un log
+def update_history(entry):
+    # Actualizar datos históricos de contenedores en memoria
+    timestamp = parser.isoparse(entry.timestamp)
+    containers = entry.sysinfo["Docker_Containers"]
+    for container in containers:
+        cmd_lower = container["Cmdline"].lower()
+        category = (
+            "cpu" if "--cpu" in cmd_lower else
+            "ram" if "--vm" in cmd_lower else
+            "io" if "--io" in cmd_lower else
+            "disk" if "--hdd" in cmd_lower else
+            "unknown"
+        )
+        if category in categories:
+            data_by_category[category]["series"].append(
+                timestamp, [container[m] for m in CONTAINER_METRICS])
+            data_by_category[category]["latest"] = {
+                "MemoryUsage_MB": container["MemoryUsage_MB"],
+                "DiskUse_MB": container["DiskUse_MB"],
+                "Write_KBytes": container["Write_KBytes"],
+                "Read_KBytes": container["Read_KBytes"],
+                "IOReadOps": container["IOReadOps"],
+                "IOWriteOps": container["IOWriteOps"],
+                "ContainerID": container["ContainerID"]
+            }
+
+    # Actualizar datos históricos del sistema en memoria
+    system_data.append(timestamp, [entry.sysinfo["Memory"][m] for m in SYSTEM_METRICS])
+
+def ingest_logs(entries):
+    store.append_many([(timestamp_ms(entry.timestamp), entry.dict()) for entry in entries])
+    for entry in entries:
+        update_history(entry)
+    new_data.set()
+
+# 📌 Endpoint para recibir logs desde Rust y agregarlos al segmento activo
 @app.post("/logs")
 def receive_log(entry: LogEntry):
     try:
-        ensure_logs_file()
-        with open(LOGS_FILE, "r+") as f:
-            logs = json.load(f)
-            logs.append(entry.dict())
-            f.seek(0)
-            json.dump(logs, f, indent=4)
-
-        # Actualizar datos históricos de contenedores en memoria
-        containers = entry.sysinfo["Docker_Containers"]
-        for container in containers:
-            cmd_lower = container["Cmdline"].lower()
-            category = (
-                "cpu" if "--cpu" in cmd_lower else
-                "ram" if "--vm" in cmd_lower else
-                "io" if "--io" in cmd_lower else
-                "disk" if "--hdd" in cmd_lower else
-                "unknown"
-            )
-            if category in categories:
-                data_by_category[category]["MemoryUsage_percent"].append(container["MemoryUsage_percent"])
-                data_by_category[category]["CPUUsage_percent"].append(container["CPUUsage_percent"])
-                data_by_category[category]["timestamps"].append(parser.isoparse(entry.timestamp))
-                data_by_category[category]["latest"] = {
-                    "MemoryUsage_MB": container["MemoryUsage_MB"],
-                    "DiskUse_MB": container["DiskUse_MB"],
-                    "Write_KBytes": container["Write_KBytes"],
-                    "Read_KBytes": container["Read_KBytes"],
-                    "IOReadOps": container["IOReadOps"],
-                    "IOWriteOps": container["IOWriteOps"],
-                    "ContainerID": container["ContainerID"]
-                }
-
-        # Actualizar datos históricos del sistema en memoria
-        system_data["Free_Memory_MB"].append(entry.sysinfo["Memory"]["Free_Memory_MB"])
-        system_data["Used_Memory_MB"].append(entry.sysinfo["Memory"]["Used_Memory_MB"])
-        system_data["CPU_Usage_Percentage"].append(entry.sysinfo["Memory"]["CPU_Usage_Percentage"])
-        system_data["timestamps"].append(parser.isoparse(entry.timestamp))
-
+        ingest_logs([entry])
         return {"message": "Log almacenado exitosamente"}
     except Exception as e:
         raise HTTPException(status_code=500, detail=str(e))
 
-# 📌 Endpoint para obtener todos los logs almacenados
-@app.get("/logs")
-def get_logs():
+# 📌 Endpoint para recibir lotes de logs: un log JSON por línea (NDJSON),
+# opcionalmente comprimido con gzip (Content-Encoding: gzip)
+MAX_BULK_BYTES = 64 * 1024 * 1024  # Tamaño máximo del lote ya descomprimido
+
+@app.post("/logs/bulk")
+async def receive_logs_bulk(request: Request):
+    body = await request.body()
+    encoding = request.headers.get("content-encoding", "identity").lower()
+    try:
+        if encoding == "gzip":
+            with gzip.GzipFile(fileobj=io.BytesIO(body)) as f:
+                body = f.read(MAX_BULK_BYTES + 1)
+        elif encoding != "identity":
+            raise HTTPException(status_code=415, detail=f"Content-Encoding no soportado: {encoding}")
+        if len(body) > MAX_BULK_BYTES:
+            raise HTTPException(status_code=413, detail="Lote demasiado grande")
+        entries = [LogEntry(**json.loads(line)) for line in body.splitlines() if line.strip()]
+        for entry in entries:
+            timestamp_ms(entry.timestamp)
+    except (OSError, EOFError, ValueError, TypeError) as e:
+        # gzip inválido, JSON inválido o log que no cumple con LogEntry
+        raise HTTPException(status_code=400, detail=f"Lote inválido: {e}")
+
     try:
-        with open(LOGS_FILE, "r") as f:
-            logs = json.load(f)
-        return logs
+        # Escritura a disco y actualización de las series fuera del ciclo de eventos
+        await run_in_threadpool(ingest_logs, entries)
     except Exception as e:
         raise HTTPException(status_code=500, detail=str(e))
+    return {"message": "Logs almacenados exitosamente", "count": len(entries)}
+
+# Agrupa las líneas en bloques de ~64 KB para no enviar un fragmento HTTP por log
+def stream_logs(lines, ndjson):
+    chunk, size = [], 0
+    first = True
+    if not ndjson:
+        chunk.append(b"[")
+    for line in lines:
+        if ndjson:
+            chunk.append(line + b"\n")
+        else:
+            chunk.append(line if first else b",\n" + line)
+        first = False
+        size += len(line)
+        if size >= 64 * 1024:
+            yield b"".join(chunk)
+            chunk, size = [], 0
+    if not ndjson:
+        chunk.append(b"]")
+    yield b"".join(chunk)
+
+# 📌 Endpoint para obtener los logs almacenados, opcionalmente en un rango de tiempo
+# start/end: ISO 8601 (inclusive); format=ndjson entrega un log por línea
+@app.get("/logs")
+def get_logs(start: Optional[str] = None, end: Optional[str] = None,
+             limit: Optional[int] = None, format: str = "json"):
+    try:
+        start_ms = timestamp_ms(start) if start else None
+        end_ms = timestamp_ms(end) if end else None
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=f"Marca de tiempo inválida: {e}")
+    if format not in ("json", "ndjson"):
+        raise HTTPException(status_code=400, detail="format debe ser json o ndjson")
+
+    ndjson = format == "ndjson"
+    media_type = "application/x-ndjson" if ndjson else "application/json"
+    return StreamingResponse(stream_logs(store.query(start_ms, end_ms, limit), ndjson), media_type=media_type)
+
+# Eje x con las horas reales y pocas etiquetas, sin importar cuántos puntos haya
+def set_time_axis(ax):
+    ax.xaxis.set_major_locator(mdates.AutoDateLocator(maxticks=8))
+    ax.xaxis.set_major_formatter(mdates.DateFormatter('%H:%M:%S'))
+    ax.tick_params(axis='x', labelrotation=45)
+
+# Con muchos puntos los marcadores tapan la línea
+def line_marker(x):
+    return 'o' if len(x) <= 60 else None
 
 # 📌 Mostrar gráficas en tiempo real
 def show_live_graphs():
     while True:
-        if not system_data["timestamps"] and not any(data["timestamps"] for data in data_by_category.values()):
-            time.sleep(5)
-            continue
+        # Solo se redibuja cuando llegó al menos un log desde el último dibujo
+        new_data.wait()
+        new_data.clear()
 
         # --- Primera gráfica: Datos generales del sistema (dona y líneas) ---
         fig, (ax_donut, ax_line) = plt.subplots(1, 2, figsize=(12, 6))  # Dos subgráficas horizontales
         fig.suptitle("Datos Generales del Sistema", fontsize=16)
 
         # Gráfica de dona: Memoria Libre y Usada (último dato)
-        memory_values = [system_data["Free_Memory_MB"][-1], system_data["Used_Memory_MB"][-1]] if system_data["Free_Memory_MB"] else [0, 0]
+        memory_values = [system_data.last("Free_Memory_MB"), system_data.last("Used_Memory_MB")] if len(system_data) else [0, 0]
         memory_colors = ['#00FF00', '#0000FF']  # Verde para libre, azul para usada
         if sum(memory_values) > 0:
             ax_donut.pie(memory_values, colors=memory_colors, startangle=90, wedgeprops=dict(width=0.3))
             metrics_text = (
-                f"Libre: {memory_values[0]} MB\n"
-                f"Usada: {memory_values[1]} MB"
+                f"Libre: {memory_values[0]:.0f} MB\n"
+                f"Usada: {memory_values[1]:.0f} MB"
             )
             ax_donut.text(0.5, -0.1, metrics_text, ha='center', va='top', fontsize=10, transform=ax_donut.transAxes)
         else:
@@ -129,13 +220,12 @@ def show_live_graphs():
         ax_donut.set_title("Uso de Memoria")
 
         # Gráfica de líneas: Uso de CPU (datos actuales)
-        if system_data["CPU_Usage_Percentage"]:
-            x = np.arange(len(system_data["timestamps"]))
-            ax_line.plot(x, system_data["CPU_Usage_Percentage"], color='#FF0000', marker='o', label=f"CPU %: {system_data['CPU_Usage_Percentage'][-1]:.1f}")
+        if len(system_data):
+            x, values = system_data.points()
+            ax_line.plot(x, values["CPU_Usage_Percentage"], color='#FF0000', marker=line_marker(x), label=f"CPU %: {system_data.last('CPU_Usage_Percentage'):.1f}")
             ax_line.set_title("Uso de CPU")
             ax_line.set_ylim(0, 210)  # Rango fijo de 0 a 210
-            ax_line.set_xticks(x)
-            ax_line.set_xticklabels([ts.strftime('%H:%M:%S') for ts in system_data["timestamps"]], rotation=45, ha='right')
+            set_time_axis(ax_line)
             ax_line.set_ylabel("Porcentaje (%)")
             ax_line.grid(axis='y')
             ax_line.legend(title="Métrica", loc="upper left")
@@ -162,26 +252,25 @@ def show_live_graphs():
         io_colors = ['#FFCC99', '#FFD700']
 
         for i, category in enumerate(categories):
-            if data_by_category[category]["latest"] is not None and data_by_category[category]["MemoryUsage_percent"]:
+            series = data_by_category[category]["series"]
+            if data_by_category[category]["latest"] is not None and len(series):
                 # --- Gráfica de líneas: RAM % (columna 1) ---
                 ax_ram = axs[i, 0]
-                x = np.arange(len(data_by_category[category]["timestamps"]))
-                ax_ram.plot(x, data_by_category[category]["MemoryUsage_percent"], color=ram_color, marker='o', label=f"RAM %: {data_by_category[category]['MemoryUsage_percent'][-1]:.2f}")
+                x, values = series.points()
+                ax_ram.plot(x, values["MemoryUsage_percent"], color=ram_color, marker=line_marker(x), label=f"RAM %: {series.last('MemoryUsage_percent'):.2f}")
                 ax_ram.set_title(f"{category.upper()} - RAM %")
                 ax_ram.set_ylim(0, 3)  # Rango fijo de 0 a 210
-                ax_ram.set_xticks(x)
-                ax_ram.set_xticklabels([ts.strftime('%H:%M:%S') for ts in data_by_category[category]["timestamps"]], rotation=45, ha='right')
+                set_time_axis(ax_ram)
                 ax_ram.set_ylabel("Porcentaje (%)")
                 ax_ram.grid(axis='y')
                 ax_ram.legend(title="Métrica", loc="upper left")
 
                 # --- Gráfica de líneas: CPU % (columna 2) ---
                 ax_cpu = axs[i, 1]
-                ax_cpu.plot(x, data_by_category[category]["CPUUsage_percent"], color=cpu_color, marker='o', label=f"CPU %: {data_by_category[category]['CPUUsage_percent'][-1]:.1f}")
+                ax_cpu.plot(x, values["CPUUsage_percent"], color=cpu_color, marker=line_marker(x), label=f"CPU %: {series.last('CPUUsage_percent'):.1f}")
                 ax_cpu.set_title(f"{category.upper()} - CPU %")
                 ax_cpu.set_ylim(0, 210)  # Rango fijo de 0 a 210
-                ax_cpu.set_xticks(x)
-                ax_cpu.set_xticklabels([ts.strftime('%H:%M:%S') for ts in data_by_category[category]["timestamps"]], rotation=45, ha='right')
+                set_time_axis(ax_cpu)
                 ax_cpu.set_ylabel("Porcentaje (%)")
                 ax_cpu.grid(axis='y')
                 ax_cpu.legend(title="Métrica", loc="upper left")
@@ -243,27 +332,16 @@ def show_live_graphs():
         plt.close()
 
         print("[INFO] Gráficas guardadas en /app/logs/")
-        time.sleep(5)
+        # Los logs que lleguen mientras tanto se dibujan juntos en la siguiente vuelta
+        time.sleep(RENDER_INTERVAL)
 
 # 📌 Iniciar el hilo de gráficas automáticamente al arrancar la aplicación
 @app.on_event("startup")
 def startup_event():
     global data_by_category, system_data
-    # Reiniciar las listas al iniciar el servidor
-    data_by_category = {
-        cat: {
-            "MemoryUsage_percent": [],
-            "CPUUsage_percent": [],
-            "timestamps": [],
-            "latest": None
-        } for cat in categories
-    }
-    system_data = {
-        "Free_Memory_MB": [],
-        "Used_Memory_MB": [],
-        "CPU_Usage_Percentage": [],
-        "timestamps": []
-    }
+    # Reiniciar el historial al iniciar el servidor
+    data_by_category = new_category_data()
+    system_data = MetricSeries(SYSTEM_METRICS)
     thread = threading.Thread(target=show_live_graphs, daemon=True)
     thread.start()
     print("[INFO] Hilo de gráficas iniciado automáticamente al arrancar la API")
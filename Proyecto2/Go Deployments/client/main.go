@@ -6,17 +6,51 @@ import (
 	"fmt"
 	"log"
 	"net/http"
+	"os"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
 
 	pb "proyecto2/proto"
 
 	"google.golang.org/grpc"
+	"google.golang.org/grpc/connectivity"
+	"google.golang.org/grpc/credentials/insecure"
+	_ "google.golang.org/grpc/health" // Habilita el health check del lado del cliente
+	"google.golang.org/grpc/keepalive"
 )
 
 var (
-	kafkaAddr  = "kafka-writer:50052"  // Servicio kafka-writer
-	rabbitAddr = "rabbit-writer:50051" // Servicio rabbit-writer
+	kafkaAddr  = envOr("KAFKA_WRITER_ADDR", "kafka-writer:50052")   // Servicio kafka-writer
+	rabbitAddr = envOr("RABBIT_WRITER_ADDR", "rabbit-writer:50051") // Servicio rabbit-writer
+
+	// Conexiones por writer; cada una es un TCP/HTTP2 propio, así kube-proxy
+	// reparte la carga entre los pods del writer
+	poolSize = envInt("GRPC_POOL_SIZE", 2)
+	// Tiempo máximo de cada Publish; Kafka y RabbitMQ se llaman en paralelo
+	publishTimeout = time.Duration(envInt("PUBLISH_TIMEOUT_MS", 2000)) * time.Millisecond
+
+	// Las peticiones concurrentes a /publicar se juntan en un PublishBatch de
+	// hasta batchMax mensajes o batchLinger de espera; con 1 se usa Publish
+	batchMax    = envInt("PUBLISH_BATCH_MAX", 500)
+	batchLinger = time.Duration(envInt("BATCH_LINGER_MS", 2)) * time.Millisecond
+	// Lotes en vuelo por writer; los demás esperan y siguen juntando mensajes
+	batchInFlight = envInt("BATCH_MAX_IN_FLIGHT", 4)
 )
 
+// round_robin reparte entre las direcciones del servicio y solo usa las que
+// responden SERVING al servicio de health de gRPC
+const serviceConfig = `{
+	"loadBalancingConfig": [{"round_robin": {}}],
+	"healthCheckConfig": {"serviceName": ""}
+}`
+
+// Límites (en segundos) del histograma de latencia de Publish y PublishBatch
+var latencyBuckets = []float64{0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5}
+
 // Estructura para parsear JSON del body HTTP
 type ClimaBody struct {
 	Description string `json:"description"`
@@ -24,8 +58,212 @@ type ClimaBody struct {
 	Weather     string `json:"weather"`
 }
 
+// Histograma acumulado de latencias por RPC de un writer, expuesto en /metrics
+type latencyMetrics struct {
+	buckets  []atomic.Uint64 // Uno por límite más +Inf, sin acumular
+	errors   atomic.Uint64
+	sumNs    atomic.Uint64
+	messages atomic.Uint64 // Mensajes enviados, un RPC puede llevar varios
+}
+
+func (m *latencyMetrics) observe(d time.Duration, messages int, failed bool) {
+	i := sort.SearchFloat64s(latencyBuckets, d.Seconds())
+	m.buckets[i].Add(1)
+	m.sumNs.Add(uint64(d.Nanoseconds()))
+	m.messages.Add(uint64(messages))
+	if failed {
+		m.errors.Add(1)
+	}
+}
+
+type publishResult struct {
+	resp *pb.PublishResponse
+	err  error
+}
+
+// Petición de /publicar esperando a que salga su lote
+type queuedPublish struct {
+	req  *pb.PublishRequest
+	done chan publishResult
+}
+
+// Conexiones gRPC de larga duración a un writer, creadas al arrancar
+type writerBackend struct {
+	key      string // Nombre en la respuesta JSON y en las métricas
+	label    string // Nombre en los mensajes de error
+	conns    []*grpc.ClientConn
+	clients  []pb.WriterServiceClient
+	next     atomic.Uint32
+	metrics  latencyMetrics
+	queue    chan *queuedPublish
+	inFlight chan struct{}
+}
+
+func newWriterBackend(key, label, addr string, size int) (*writerBackend, error) {
+	b := &writerBackend{
+		key:      key,
+		label:    label,
+		queue:    make(chan *queuedPublish, batchMax),
+		inFlight: make(chan struct{}, batchInFlight),
+	}
+	b.metrics.buckets = make([]atomic.Uint64, len(latencyBuckets)+1)
+	for i := 0; i < size; i++ {
+		// Insecure para simplificar. En producción usar TLS
+		conn, err := grpc.NewClient(addr,
+			grpc.WithTransportCredentials(insecure.NewCredentials()),
+			grpc.WithDefaultServiceConfig(serviceConfig),
+			grpc.WithKeepaliveParams(keepalive.ClientParameters{
+				Time:                20 * time.Second,
+				Timeout:             5 * time.Second,
+				PermitWithoutStream: true,
+			}),
+			grpc.WithIdleTimeout(0), // La conexión no se cierra aunque no haya tráfico
+		)
+		if err != nil {
+			b.close()
+			return nil, fmt.Errorf("conexión a %s: %w", addr, err)
+		}
+		conn.Connect()
+		b.conns = append(b.conns, conn)
+		b.clients = append(b.clients, pb.NewWriterServiceClient(conn))
+	}
+	if batchMax > 1 {
+		go b.runBatches()
+	}
+	return b, nil
+}
+
+func (b *writerBackend) client() pb.WriterServiceClient {
+	i := b.next.Add(1)
+	return b.clients[int(i)%len(b.clients)]
+}
+
+// Al menos una conexión lista o intentando conectar sin haber fallado
+func (b *writerBackend) healthy() bool {
+	for _, conn := range b.conns {
+		switch conn.GetState() {
+		case connectivity.Ready, connectivity.Idle, connectivity.Connecting:
+			return true
+		}
+	}
+	return false
+}
+
+func (b *writerBackend) ready() int {
+	for _, conn := range b.conns {
+		if conn.GetState() == connectivity.Ready {
+			return 1
+		}
+	}
+	return 0
+}
+
+func (b *writerBackend) publish(ctx context.Context, req *pb.PublishRequest) (*pb.PublishResponse, error) {
+	if batchMax <= 1 {
+		return b.publishUnary(ctx, req)
+	}
+
+	p := &queuedPublish{req: req, done: make(chan publishResult, 1)}
+	select {
+	case b.queue <- p:
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+	select {
+	case result := <-p.done:
+		return result.resp, result.err
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+}
+
+func (b *writerBackend) publishUnary(ctx context.Context, req *pb.PublishRequest) (*pb.PublishResponse, error) {
+	ctx, cancel := context.WithTimeout(ctx, publishTimeout)
+	defer cancel()
+
+	start := time.Now()
+	resp, err := b.client().Publish(ctx, req)
+	b.metrics.observe(time.Since(start), 1, err != nil || !resp.GetSuccess())
+	if err != nil {
+		return nil, fmt.Errorf("Publish RPC failed: %w", err)
+	}
+	return resp, nil
+}
+
+// Junta las peticiones encoladas en lotes y manda cada lote en su propia
+// goroutine, con a lo sumo batchInFlight lotes en vuelo
+func (b *writerBackend) runBatches() {
+	for first := range b.queue {
+		batch := []*queuedPublish{first}
+		timer := time.NewTimer(batchLinger)
+	collect:
+		for len(batch) < batchMax {
+			select {
+			case next := <-b.queue:
+				batch = append(batch, next)
+			case <-timer.C:
+				break collect
+			}
+		}
+		timer.Stop()
+
+		b.inFlight <- struct{}{}
+		go func(batch []*queuedPublish) {
+			defer func() { <-b.inFlight }()
+			b.publishBatch(batch)
+		}(batch)
+	}
+}
+
+// Un solo PublishBatch para todo el lote; cada petición recibe el resultado del lote
+func (b *writerBackend) publishBatch(batch []*queuedPublish) {
+	ctx, cancel := context.WithTimeout(context.Background(), publishTimeout)
+	defer cancel()
+
+	msgs := make([]*pb.PublishRequest, len(batch))
+	for i, p := range batch {
+		msgs[i] = p.req
+	}
+
+	start := time.Now()
+	resp, err := b.client().PublishBatch(ctx, &pb.PublishBatchRequest{Messages: msgs})
+	b.metrics.observe(time.Since(start), len(batch), err != nil || !resp.GetSuccess())
+
+	var result publishResult
+	if err != nil {
+		result.err = fmt.Errorf("PublishBatch RPC failed: %w", err)
+	} else {
+		result.resp = &pb.PublishResponse{Success: resp.Success, Info: resp.Info}
+	}
+	for _, p := range batch {
+		p.done <- result
+	}
+}
+
+func (b *writerBackend) close() {
+	for _, conn := range b.conns {
+		conn.Close()
+	}
+}
+
+var backends []*writerBackend
+
 func main() {
+	kafka, err := newWriterBackend("kafka", "Kafka", kafkaAddr, poolSize)
+	if err != nil {
+		log.Fatalf("Error creando cliente de Kafka: %v", err)
+	}
+	defer kafka.close()
+	rabbit, err := newWriterBackend("rabbit", "RabbitMQ", rabbitAddr, poolSize)
+	if err != nil {
+		log.Fatalf("Error creando cliente de RabbitMQ: %v", err)
+	}
+	defer rabbit.close()
+	backends = []*writerBackend{kafka, rabbit}
+
 	http.HandleFunc("/publicar", publicarHandler)
+	http.HandleFunc("/healthz", healthzHandler)
+	http.HandleFunc("/metrics", metricsHandler)
 
 	log.Println("API REST gRPC Client corriendo en :8080")
 	log.Fatal(http.ListenAndServe(":8080", nil))
@@ -44,52 +282,112 @@ func publicarHandler(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
-	// Llamar a Kafka
-	respKafka, err := callWriterService(kafkaAddr, data)
-	if err != nil {
-		http.Error(w, "Error publicando en Kafka: "+err.Error(), http.StatusInternalServerError)
-		return
+	// Construir la request
+	req := &pb.PublishRequest{
+		Description: data.Description,
+		Country:     data.Country,
+		Weather:     data.Weather,
 	}
 
-	// Llamar a RabbitMQ
-	respRabbit, err := callWriterService(rabbitAddr, data)
-	if err != nil {
-		http.Error(w, "Error publicando en RabbitMQ: "+err.Error(), http.StatusInternalServerError)
-		return
+	// Publicar en Kafka y RabbitMQ a la vez: la latencia es la del más lento, no la suma
+	type result struct {
+		resp *pb.PublishResponse
+		err  error
+	}
+	results := make([]result, len(backends))
+	var wg sync.WaitGroup
+	for i, b := range backends {
+		wg.Add(1)
+		go func(i int, b *writerBackend) {
+			defer wg.Done()
+			resp, err := b.publish(r.Context(), req)
+			results[i] = result{resp, err}
+		}(i, b)
 	}
+	wg.Wait()
 
 	// Responder con estado de ambos
-	response := map[string]interface{}{
-		"kafka":  respKafka,
-		"rabbit": respRabbit,
+	response := map[string]interface{}{}
+	for i, b := range backends {
+		if results[i].err != nil {
+			http.Error(w, "Error publicando en "+b.label+": "+results[i].err.Error(), http.StatusInternalServerError)
+			return
+		}
+		response[b.key] = results[i].resp
 	}
 	w.Header().Set("Content-Type", "application/json")
 	json.NewEncoder(w).Encode(response)
 }
 
-// callWriterService se conecta a un servidor gRPC, llama Publish
-func callWriterService(addr string, data ClimaBody) (*pb.PublishResponse, error) {
-	// Conectar a gRPC (Insecure para simplificar. En producción usar TLS)
-	conn, err := grpc.Dial(addr, grpc.WithInsecure())
-	if err != nil {
-		return nil, fmt.Errorf("Dial failed: %w", err)
+// 200 si todos los writers tienen una conexión utilizable; para la readinessProbe
+func healthzHandler(w http.ResponseWriter, r *http.Request) {
+	status := map[string]string{}
+	code := http.StatusOK
+	for _, b := range backends {
+		if b.healthy() {
+			status[b.key] = "ok"
+		} else {
+			status[b.key] = "unavailable"
+			code = http.StatusServiceUnavailable
+		}
 	}
-	defer conn.Close()
+	w.Header().Set("Content-Type", "application/json")
+	w.WriteHeader(code)
+	json.NewEncoder(w).Encode(status)
+}
 
-	client := pb.NewWriterServiceClient(conn)
+// Métricas en el formato de texto de Prometheus
+func metricsHandler(w http.ResponseWriter, r *http.Request) {
+	var sb strings.Builder
 
-	// Construir la request
-	req := &pb.PublishRequest{
-		Description: data.Description,
-		Country:     data.Country,
-		Weather:     data.Weather,
+	sb.WriteString("# HELP goclient_publish_duration_seconds Latencia de cada RPC (Publish o PublishBatch) por writer.\n")
+	sb.WriteString("# TYPE goclient_publish_duration_seconds histogram\n")
+	for _, b := range backends {
+		var cumulative uint64
+		for i := range b.metrics.buckets {
+			cumulative += b.metrics.buckets[i].Load()
+			le := "+Inf"
+			if i < len(latencyBuckets) {
+				le = strconv.FormatFloat(latencyBuckets[i], 'g', -1, 64)
+			}
+			fmt.Fprintf(&sb, "goclient_publish_duration_seconds_bucket{backend=%q,le=%q} %d\n", b.key, le, cumulative)
+		}
+		fmt.Fprintf(&sb, "goclient_publish_duration_seconds_sum{backend=%q} %g\n", b.key, float64(b.metrics.sumNs.Load())/1e9)
+		fmt.Fprintf(&sb, "goclient_publish_duration_seconds_count{backend=%q} %d\n", b.key, cumulative)
 	}
 
-	// Llamar al método Publish
-	resp, err := client.Publish(context.Background(), req)
-	if err != nil {
-		return nil, fmt.Errorf("Publish RPC failed: %w", err)
+	sb.WriteString("# HELP goclient_publish_messages_total Mensajes enviados por writer.\n")
+	sb.WriteString("# TYPE goclient_publish_messages_total counter\n")
+	for _, b := range backends {
+		fmt.Fprintf(&sb, "goclient_publish_messages_total{backend=%q} %d\n", b.key, b.metrics.messages.Load())
 	}
 
-	return resp, nil
+	sb.WriteString("# HELP goclient_publish_errors_total RPC fallidos o con success=false por writer.\n")
+	sb.WriteString("# TYPE goclient_publish_errors_total counter\n")
+	for _, b := range backends {
+		fmt.Fprintf(&sb, "goclient_publish_errors_total{backend=%q} %d\n", b.key, b.metrics.errors.Load())
+	}
+
+	sb.WriteString("# HELP goclient_writer_ready 1 si alguna conexión al writer está lista.\n")
+	sb.WriteString("# TYPE goclient_writer_ready gauge\n")
+	for _, b := range backends {
+		fmt.Fprintf(&sb, "goclient_writer_ready{backend=%q} %d\n", b.key, b.ready())
+	}
+
+	w.Header().Set("Content-Type", "text/plain; version=0.0.4")
+	w.Write([]byte(sb.String()))
+}
+
+func envOr(name, def string) string {
+	if v := os.Getenv(name); v != "" {
+		return v
+	}
+	return def
+}
+
+func envInt(name string, def int) int {
+	if v, err := strconv.Atoi(os.Getenv(name)); err == nil && v > 0 {
+		return v
+	}
+	return def
 }
@@ -135,6 +135,112 @@ func (x *PublishResponse) GetInfo() string {
 	return ""
 }
 
+// Lote de mensajes, se publican en el mismo orden
+type PublishBatchRequest struct {
+	state         protoimpl.MessageState `protogen:"open.v1"`
+	Messages      []*PublishRequest      `protobuf:"bytes,1,rep,name=messages,proto3" json:"messages,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *PublishBatchRequest) Reset() {
+	*x = PublishBatchRequest{}
+	mi := &file_proto_writer_proto_msgTypes[2]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *PublishBatchRequest) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*PublishBatchRequest) ProtoMessage() {}
+
+func (x *PublishBatchRequest) ProtoReflect() protoreflect.Message {
+	mi := &file_proto_writer_proto_msgTypes[2]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use PublishBatchRequest.ProtoReflect.Descriptor instead.
+func (*PublishBatchRequest) Descriptor() ([]byte, []int) {
+	return file_proto_writer_proto_rawDescGZIP(), []int{2}
+}
+
+func (x *PublishBatchRequest) GetMessages() []*PublishRequest {
+	if x != nil {
+		return x.Messages
+	}
+	return nil
+}
+
+// Respuesta del lote: success es verdadero solo si se publicaron todos
+type PublishBatchResponse struct {
+	state         protoimpl.MessageState `protogen:"open.v1"`
+	Success       bool                   `protobuf:"varint,1,opt,name=success,proto3" json:"success,omitempty"`
+	Info          string                 `protobuf:"bytes,2,opt,name=info,proto3" json:"info,omitempty"`
+	Published     int32                  `protobuf:"varint,3,opt,name=published,proto3" json:"published,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *PublishBatchResponse) Reset() {
+	*x = PublishBatchResponse{}
+	mi := &file_proto_writer_proto_msgTypes[3]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *PublishBatchResponse) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*PublishBatchResponse) ProtoMessage() {}
+
+func (x *PublishBatchResponse) ProtoReflect() protoreflect.Message {
+	mi := &file_proto_writer_proto_msgTypes[3]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use PublishBatchResponse.ProtoReflect.Descriptor instead.
+func (*PublishBatchResponse) Descriptor() ([]byte, []int) {
+	return file_proto_writer_proto_rawDescGZIP(), []int{3}
+}
+
+func (x *PublishBatchResponse) GetSuccess() bool {
+	if x != nil {
+		return x.Success
+	}
+	return false
+}
+
+func (x *PublishBatchResponse) GetInfo() string {
+	if x != nil {
+		return x.Info
+	}
+	return ""
+}
+
+func (x *PublishBatchResponse) GetPublished() int32 {
+	if x != nil {
+		return x.Published
+	}
+	return 0
+}
+
 var File_proto_writer_proto protoreflect.FileDescriptor
 
 const file_proto_writer_proto_rawDesc = "" +
@@ -146,9 +252,16 @@ const file_proto_writer_proto_rawDesc = "" +
 	"\aweather\x18\x03 \x01(\tR\aweather\"?\n" +
 	"\x0fPublishResponse\x12\x18\n" +
 	"\asuccess\x18\x01 \x01(\bR\asuccess\x12\x12\n" +
-	"\x04info\x18\x02 \x01(\tR\x04info2K\n" +
+	"\x04info\x18\x02 \x01(\tR\x04info\"I\n" +
+	"\x13PublishBatchRequest\x122\n" +
+	"\bmessages\x18\x01 \x03(\v2\x16.writer.PublishRequestR\bmessages\"b\n" +
+	"\x14PublishBatchResponse\x12\x18\n" +
+	"\asuccess\x18\x01 \x01(\bR\asuccess\x12\x12\n" +
+	"\x04info\x18\x02 \x01(\tR\x04info\x12\x1c\n" +
+	"\tpublished\x18\x03 \x01(\x05R\tpublished2\x96\x01\n" +
 	"\rWriterService\x12:\n" +
-	"\aPublish\x12\x16.writer.PublishRequest\x1a\x17.writer.PublishResponseB\x18Z\x16proyecto2/proto;writerb\x06proto3"
+	"\aPublish\x12\x16.writer.PublishRequest\x1a\x17.writer.PublishResponse\x12I\n" +
+	"\fPublishBatch\x12\x1b.writer.PublishBatchRequest\x1a\x1c.writer.PublishBatchResponseB\x18Z\x16proyecto2/proto;writerb\x06proto3"
 
 var (
 	file_proto_writer_proto_rawDescOnce sync.Once
@@ -162,19 +275,24 @@ func file_proto_writer_proto_rawDescGZIP() []byte {
 	return file_proto_writer_proto_rawDescData
 }
 
-var file_proto_writer_proto_msgTypes = make([]protoimpl.MessageInfo, 2)
+var file_proto_writer_proto_msgTypes = make([]protoimpl.MessageInfo, 4)
 var file_proto_writer_proto_goTypes = []any{
-	(*PublishRequest)(nil),  // 0: writer.PublishRequest
-	(*PublishResponse)(nil), // 1: writer.PublishResponse
+	(*PublishRequest)(nil),       // 0: writer.PublishRequest
+	(*PublishResponse)(nil),      // 1: writer.PublishResponse
+	(*PublishBatchRequest)(nil),  // 2: writer.PublishBatchRequest
+	(*PublishBatchResponse)(nil), // 3: writer.PublishBatchResponse
 }
 var file_proto_writer_proto_depIdxs = []int32{
-	0, // 0: writer.WriterService.Publish:input_type -> writer.PublishRequest
-	1, // 1: writer.WriterService.Publish:output_type -> writer.PublishResponse
-	1, // [1:2] is the sub-list for method output_type
-	0, // [0:1] is the sub-list for method input_type
-	0, // [0:0] is the sub-list for extension type_name
-	0, // [0:0] is the sub-list for extension extendee
-	0, // [0:0] is the sub-list for field type_name
+	0, // 0: writer.PublishBatchRequest.messages:type_name -> writer.PublishRequest
+	0, // 1: writer.WriterService.Publish:input_type -> writer.PublishRequest
+	2, // 2: writer.WriterService.PublishBatch:input_type -> writer.PublishBatchRequest
+	1, // 3: writer.WriterService.Publish:output_type -> writer.PublishResponse
+	3, // 4: writer.WriterService.PublishBatch:output_type -> writer.PublishBatchResponse
+	3, // [3:5] is the sub-list for method output_type
+	1, // [1:3] is the sub-list for method input_type
+	1, // [1:1] is the sub-list for extension type_name
+	1, // [1:1] is the sub-list for extension extendee
+	0, // [0:1] is the sub-list for field type_name
 }
 
 func init() { file_proto_writer_proto_init() }
@@ -188,7 +306,7 @@ func file_proto_writer_proto_init() {
 			GoPackagePath: reflect.TypeOf(x{}).PkgPath(),
 			RawDescriptor: unsafe.Slice(unsafe.StringData(file_proto_writer_proto_rawDesc), len(file_proto_writer_proto_rawDesc)),
 			NumEnums:      0,
-			NumMessages:   2,
+			NumMessages:   4,
 			NumExtensions: 0,
 			NumServices:   1,
 		},
@@ -19,7 +19,8 @@ import (
 const _ = grpc.SupportPackageIsVersion9
 
 const (
-	WriterService_Publish_FullMethodName = "/writer.WriterService/Publish"
+	WriterService_Publish_FullMethodName      = "/writer.WriterService/Publish"
+	WriterService_PublishBatch_FullMethodName = "/writer.WriterService/PublishBatch"
 )
 
 // WriterServiceClient is the client API for WriterService service.
@@ -29,6 +30,8 @@ const (
 // Servicio que se encargará de publicar el mensaje en un Broker
 type WriterServiceClient interface {
 	Publish(ctx context.Context, in *PublishRequest, opts ...grpc.CallOption) (*PublishResponse, error)
+	// Varios mensajes en una sola llamada; el writer los escribe al broker en lotes
+	PublishBatch(ctx context.Context, in *PublishBatchRequest, opts ...grpc.CallOption) (*PublishBatchResponse, error)
 }
 
 type writerServiceClient struct {
@@ -49,6 +52,16 @@ func (c *writerServiceClient) Publish(ctx context.Context, in *PublishRequest, o
 	return out, nil
 }
 
+func (c *writerServiceClient) PublishBatch(ctx context.Context, in *PublishBatchRequest, opts ...grpc.CallOption) (*PublishBatchResponse, error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	out := new(PublishBatchResponse)
+	err := c.cc.Invoke(ctx, WriterService_PublishBatch_FullMethodName, in, out, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	return out, nil
+}
+
 // WriterServiceServer is the server API for WriterService service.
 // All implementations must embed UnimplementedWriterServiceServer
 // for forward compatibility.
@@ -56,6 +69,8 @@ func (c *writerServiceClient) Publish(ctx context.Context, in *PublishRequest, o
 // Servicio que se encargará de publicar el mensaje en un Broker
 type WriterServiceServer interface {
 	Publish(context.Context, *PublishRequest) (*PublishResponse, error)
+	// Varios mensajes en una sola llamada; el writer los escribe al broker en lotes
+	PublishBatch(context.Context, *PublishBatchRequest) (*PublishBatchResponse, error)
 	mustEmbedUnimplementedWriterServiceServer()
 }
 
@@ -69,6 +84,9 @@ type UnimplementedWriterServiceServer struct{}
 func (UnimplementedWriterServiceServer) Publish(context.Context, *PublishRequest) (*PublishResponse, error) {
 	return nil, status.Errorf(codes.Unimplemented, "method Publish not implemented")
 }
+func (UnimplementedWriterServiceServer) PublishBatch(context.Context, *PublishBatchRequest) (*PublishBatchResponse, error) {
+	return nil, status.Errorf(codes.Unimplemented, "method PublishBatch not implemented")
+}
 func (UnimplementedWriterServiceServer) mustEmbedUnimplementedWriterServiceServer() {}
 func (UnimplementedWriterServiceServer) testEmbeddedByValue()                       {}
 
@@ -108,6 +126,24 @@ func _WriterService_Publish_Handler(srv interface{}, ctx context.Context, dec fu
 	return interceptor(ctx, in, info, handler)
 }
 
+func _WriterService_PublishBatch_Handler(srv interface{}, ctx context.Context, dec func(interface{}) error, interceptor grpc.UnaryServerInterceptor) (interface{}, error) {
+	in := new(PublishBatchRequest)
+	if err := dec(in); err != nil {
+		return nil, err
+	}
+	if interceptor == nil {
+		return srv.(WriterServiceServer).PublishBatch(ctx, in)
+	}
+	info := &grpc.UnaryServerInfo{
+		Server:     srv,
+		FullMethod: WriterService_PublishBatch_FullMethodName,
+	}
+	handler := func(ctx context.Context, req interface{}) (interface{}, error) {
+		return srv.(WriterServiceServer).PublishBatch(ctx, req.(*PublishBatchRequest))
+	}
+	return interceptor(ctx, in, info, handler)
+}
+
 // WriterService_ServiceDesc is the grpc.ServiceDesc for WriterService service.
 // It's only intended for direct use with grpc.RegisterService,
 // and not to be introspected or modified (even as a copy)
@@ -119,6 +155,10 @@ var WriterService_ServiceDesc = grpc.ServiceDesc{
 			MethodName: "Publish",
 			Handler:    _WriterService_Publish_Handler,
 		},
+		{
+			MethodName: "PublishBatch",
+			Handler:    _WriterService_PublishBatch_Handler,
+		},
 	},
 	Streams:  []grpc.StreamDesc{},
 	Metadata: "proto/writer.proto",
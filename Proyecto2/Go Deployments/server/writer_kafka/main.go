@@ -2,15 +2,31 @@ package main
 
 import (
 	"context"
+	"encoding/json"
 	"fmt"
 	"log"
 	"net"
+	"os"
+	"strconv"
+	"sync"
+	"sync/atomic"
+	"time"
 
 	pb "proyecto2/proto"
 
 	"github.com/segmentio/kafka-go"
 
 	"google.golang.org/grpc"
+	"google.golang.org/grpc/health"
+	healthpb "google.golang.org/grpc/health/grpc_health_v1"
+	"google.golang.org/grpc/keepalive"
+)
+
+var (
+	// Tiempo máximo que un mensaje espera a que se llene su lote
+	lingerTime = time.Duration(envInt("KAFKA_LINGER_MS", 5)) * time.Millisecond
+	batchSize  = envInt("KAFKA_BATCH_SIZE", 1000)
+	batchBytes = envInt("KAFKA_BATCH_BYTES", 1<<20)
 )
 
 type kafkaServer struct {
@@ -18,25 +34,100 @@ type kafkaServer struct {
 	writer *kafka.Writer
 }
 
+// Cuerpo del mensaje; encoding/json escapa comillas y caracteres de control
+type climaMessage struct {
+	Description string `json:"description"`
+	Country     string `json:"country"`
+	Weather     string `json:"weather"`
+}
+
+// Espera de un Publish o PublishBatch: el writer la completa por cada mensaje
+// escrito desde Completion, y al completarse todos se libera done
+type pendingWrite struct {
+	remaining atomic.Int32
+	mu        sync.Mutex
+	err       error
+	done      chan struct{}
+}
+
+func newPendingWrite(n int) *pendingWrite {
+	p := &pendingWrite{done: make(chan struct{})}
+	p.remaining.Store(int32(n))
+	return p
+}
+
+func (p *pendingWrite) complete(err error) {
+	if err != nil {
+		p.mu.Lock()
+		if p.err == nil {
+			p.err = err
+		}
+		p.mu.Unlock()
+	}
+	if p.remaining.Add(-1) == 0 {
+		close(p.done)
+	}
+}
+
+func (p *pendingWrite) wait(ctx context.Context) error {
+	select {
+	case <-p.done:
+		p.mu.Lock()
+		defer p.mu.Unlock()
+		return p.err
+	case <-ctx.Done():
+		return ctx.Err()
+	}
+}
+
 // Inicializar el escritor de Kafka
+// Es asíncrono: WriteMessages solo encola y el writer junta en un lote los
+// mensajes de todas las peticiones (hasta batchSize mensajes, batchBytes bytes
+// o lingerTime de espera), lo comprime con LZ4 y lo manda en un solo produce.
+// Completion avisa a cada petición cuando sus mensajes quedaron escritos
 func newKafkaServer() *kafkaServer {
 	writer := &kafka.Writer{
-		Addr:     kafka.TCP("my-cluster-kafka-bootstrap.proyecto2.svc.cluster.local:9092"),
-		Topic:    "clima-topic",
-		Balancer: &kafka.LeastBytes{},
+		Addr:         kafka.TCP("my-cluster-kafka-bootstrap.proyecto2.svc.cluster.local:9092"),
+		Topic:        "clima-topic",
+		Balancer:     &kafka.LeastBytes{},
+		BatchTimeout: lingerTime,
+		BatchSize:    batchSize,
+		BatchBytes:   int64(batchBytes),
+		Compression:  kafka.Lz4,
+		RequiredAcks: kafka.RequireOne,
+		Async:        true,
+		Completion: func(messages []kafka.Message, err error) {
+			for _, msg := range messages {
+				if p, ok := msg.WriterData.(*pendingWrite); ok {
+					p.complete(err)
+				}
+			}
+		},
 	}
 	return &kafkaServer{writer: writer}
 }
 
-func (s *kafkaServer) Publish(ctx context.Context, req *pb.PublishRequest) (*pb.PublishResponse, error) {
-	// Crear el mensaje para Kafka
-	msg := kafka.Message{
-		Value: []byte(fmt.Sprintf(`{"description":"%s","country":"%s","weather":"%s"}`,
-			req.Description, req.Country, req.Weather)),
+// Encola los mensajes y espera a que Kafka confirme todos
+func (s *kafkaServer) write(ctx context.Context, reqs []*pb.PublishRequest) error {
+	pending := newPendingWrite(len(reqs))
+	msgs := make([]kafka.Message, len(reqs))
+	for i, req := range reqs {
+		value, err := json.Marshal(climaMessage{req.Description, req.Country, req.Weather})
+		if err != nil {
+			return err
+		}
+		msgs[i] = kafka.Message{Value: value, WriterData: pending}
+	}
+
+	if err := s.writer.WriteMessages(ctx, msgs...); err != nil {
+		return err
 	}
+	return pending.wait(ctx)
+}
 
+func (s *kafkaServer) Publish(ctx context.Context, req *pb.PublishRequest) (*pb.PublishResponse, error) {
 	// Publicar en Kafka
-	err := s.writer.WriteMessages(ctx, msg)
+	err := s.write(ctx, []*pb.PublishRequest{req})
 	if err != nil {
 		log.Printf("Error publicando en Kafka: %v", err)
 		return &pb.PublishResponse{
@@ -53,12 +144,42 @@ func (s *kafkaServer) Publish(ctx context.Context, req *pb.PublishRequest) (*pb.
 	}, nil
 }
 
+func (s *kafkaServer) PublishBatch(ctx context.Context, req *pb.PublishBatchRequest) (*pb.PublishBatchResponse, error) {
+	if len(req.Messages) == 0 {
+		return &pb.PublishBatchResponse{Success: true, Info: "Lote vacío"}, nil
+	}
+
+	err := s.write(ctx, req.Messages)
+	if err != nil {
+		log.Printf("Error publicando lote de %d en Kafka: %v", len(req.Messages), err)
+		return &pb.PublishBatchResponse{
+			Success: false,
+			Info:    fmt.Sprintf("Error publicando en Kafka: %v", err),
+		}, nil
+	}
+
+	log.Printf("[Kafka] Publicado lote de %d mensajes", len(req.Messages))
+
+	return &pb.PublishBatchResponse{
+		Success:   true,
+		Info:      "Publicado en Kafka con éxito",
+		Published: int32(len(req.Messages)),
+	}, nil
+}
+
 func (s *kafkaServer) Close() {
 	if s.writer != nil {
 		s.writer.Close()
 	}
 }
 
+func envInt(name string, def int) int {
+	if v, err := strconv.Atoi(os.Getenv(name)); err == nil && v > 0 {
+		return v
+	}
+	return def
+}
+
 func main() {
 	lis, err := net.Listen("tcp", ":50052")
 	if err != nil {
@@ -69,8 +190,14 @@ func main() {
 	server := newKafkaServer()
 	defer server.Close()
 
-	grpcServer := grpc.NewServer()
+	// goclient mantiene las conexiones abiertas y manda pings cada 20 s
+	grpcServer := grpc.NewServer(grpc.KeepaliveEnforcementPolicy(keepalive.EnforcementPolicy{
+		MinTime:             10 * time.Second,
+		PermitWithoutStream: true,
+	}))
 	pb.RegisterWriterServiceServer(grpcServer, server)
+	// Servicio de health de gRPC: goclient solo usa las conexiones que responden SERVING
+	healthpb.RegisterHealthServer(grpcServer, health.NewServer())
 
 	if err := grpcServer.Serve(lis); err != nil {
 		log.Fatalf("Error al iniciar servidor gRPC: %v", err)
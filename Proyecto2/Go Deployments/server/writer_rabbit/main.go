@@ -2,21 +2,52 @@ package main
 
 import (
 	"context"
+	"encoding/json"
+	"errors"
 	"fmt"
 	"log"
 	"net"
+	"os"
+	"strconv"
+	"time"
 
 	pb "proyecto2/proto"
 
 	amqp "github.com/rabbitmq/amqp091-go"
 
 	"google.golang.org/grpc"
+	"google.golang.org/grpc/health"
+	healthpb "google.golang.org/grpc/health/grpc_health_v1"
+	"google.golang.org/grpc/keepalive"
+)
+
+var (
+	// Tiempo máximo que una petición espera a que se llene su lote
+	lingerTime = time.Duration(envInt("RABBIT_LINGER_MS", 2)) * time.Millisecond
+	batchBytes = envInt("RABBIT_BATCH_BYTES", 1<<20)
+	// Tiempo máximo para publicar un lote y recibir sus confirmaciones
+	confirmTimeout = time.Duration(envInt("RABBIT_CONFIRM_TIMEOUT_MS", 5000)) * time.Millisecond
 )
 
 type server struct {
 	pb.UnimplementedWriterServiceServer
 	conn *amqp.Connection
 	ch   *amqp.Channel
+	jobs chan publishJob
+}
+
+// Cuerpo del mensaje; encoding/json escapa comillas y caracteres de control
+type climaMessage struct {
+	Description string `json:"description"`
+	Country     string `json:"country"`
+	Weather     string `json:"weather"`
+}
+
+// Mensajes de un Publish o PublishBatch; done recibe el resultado de todos
+type publishJob struct {
+	bodies [][]byte
+	size   int
+	done   chan error
 }
 
 func main() {
@@ -46,35 +77,146 @@ func main() {
 		log.Fatalf("Error declarando cola: %v", err)
 	}
 
+	// Modo confirmación: RabbitMQ confirma los mensajes y con un lote en
+	// vuelo confirma varios a la vez
+	if err := ch.Confirm(false); err != nil {
+		log.Fatalf("Error activando confirmaciones: %v", err)
+	}
+
+	srv := &server{conn: conn, ch: ch, jobs: make(chan publishJob, 1024)}
+	go srv.runBatches()
+
 	// Iniciar servidor gRPC
 	lis, err := net.Listen("tcp", ":50051")
 	if err != nil {
 		log.Fatalf("Error iniciando servidor: %v", err)
 	}
 
-	s := grpc.NewServer()
-	pb.RegisterWriterServiceServer(s, &server{conn: conn, ch: ch})
+	// goclient mantiene las conexiones abiertas y manda pings cada 20 s
+	s := grpc.NewServer(grpc.KeepaliveEnforcementPolicy(keepalive.EnforcementPolicy{
+		MinTime:             10 * time.Second,
+		PermitWithoutStream: true,
+	}))
+	pb.RegisterWriterServiceServer(s, srv)
+
+	// Servicio de health de gRPC: si se cae la conexión o el canal de RabbitMQ
+	// el writer pasa a NOT_SERVING y goclient deja de mandarle mensajes
+	healthServer := health.NewServer()
+	healthpb.RegisterHealthServer(s, healthServer)
+	connClosed := conn.NotifyClose(make(chan *amqp.Error, 1))
+	chClosed := ch.NotifyClose(make(chan *amqp.Error, 1))
+	go func() {
+		var err *amqp.Error
+		select {
+		case err = <-connClosed:
+		case err = <-chClosed:
+		}
+		if err != nil {
+			log.Printf("Conexión a RabbitMQ cerrada: %v", err)
+		}
+		healthServer.SetServingStatus("", healthpb.HealthCheckResponse_NOT_SERVING)
+	}()
+
 	log.Println("RabbitMQ gRPC Server corriendo en :50051")
 	if err := s.Serve(lis); err != nil {
 		log.Fatalf("Error sirviendo: %v", err)
 	}
 }
 
+// Junta las peticiones que llegan durante lingerTime (o hasta batchBytes) y
+// las publica juntas. Es la única goroutine que usa el canal de RabbitMQ
+func (s *server) runBatches() {
+	for job := range s.jobs {
+		batch := []publishJob{job}
+		size := job.size
+		timer := time.NewTimer(lingerTime)
+	collect:
+		for size < batchBytes {
+			select {
+			case next := <-s.jobs:
+				batch = append(batch, next)
+				size += next.size
+			case <-timer.C:
+				break collect
+			}
+		}
+		timer.Stop()
+		s.publishBatch(batch)
+	}
+}
+
+// Publica todos los mensajes del lote y después espera las confirmaciones,
+// así el lote paga una sola espera al broker y no una por mensaje
+func (s *server) publishBatch(batch []publishJob) {
+	ctx, cancel := context.WithTimeout(context.Background(), confirmTimeout)
+	defer cancel()
+
+	confirms := make([][]*amqp.DeferredConfirmation, len(batch))
+	errs := make([]error, len(batch))
+	for i, job := range batch {
+		for _, body := range job.bodies {
+			dc, err := s.ch.PublishWithDeferredConfirmWithContext(
+				ctx,
+				"",            // exchange
+				"clima-queue", // routing key
+				false,         // mandatory
+				false,         // immediate
+				amqp.Publishing{
+					ContentType: "application/json",
+					Body:        body,
+				},
+			)
+			if err != nil {
+				errs[i] = err
+				break
+			}
+			confirms[i] = append(confirms[i], dc)
+		}
+	}
+
+	for i, job := range batch {
+		for _, dc := range confirms[i] {
+			if errs[i] != nil {
+				break
+			}
+			ok, err := dc.WaitContext(ctx)
+			if err != nil {
+				errs[i] = err
+			} else if !ok {
+				errs[i] = errors.New("RabbitMQ rechazó el mensaje")
+			}
+		}
+		job.done <- errs[i]
+	}
+}
+
+// Encola los mensajes en el lote en curso y espera su resultado
+func (s *server) publish(ctx context.Context, reqs []*pb.PublishRequest) error {
+	job := publishJob{bodies: make([][]byte, len(reqs)), done: make(chan error, 1)}
+	for i, req := range reqs {
+		body, err := json.Marshal(climaMessage{req.Description, req.Country, req.Weather})
+		if err != nil {
+			return err
+		}
+		job.bodies[i] = body
+		job.size += len(body)
+	}
+
+	select {
+	case s.jobs <- job:
+	case <-ctx.Done():
+		return ctx.Err()
+	}
+	select {
+	case err := <-job.done:
+		return err
+	case <-ctx.Done():
+		return ctx.Err()
+	}
+}
+
 func (s *server) Publish(ctx context.Context, req *pb.PublishRequest) (*pb.PublishResponse, error) {
-	body := fmt.Sprintf(`{"description":"%s","country":"%s","weather":"%s"}`,
-		req.Description, req.Country, req.Weather)
-
-	err := s.ch.PublishWithContext(
-		ctx,
-		"",            // exchange
-		"clima-queue", // routing key
-		false,         // mandatory
-		false,         // immediate
-		amqp.Publishing{
-			ContentType: "application/json",
-			Body:        []byte(body),
-		},
-	)
+	err := s.publish(ctx, []*pb.PublishRequest{req})
 	if err != nil {
 		return &pb.PublishResponse{
 			Success: false,
@@ -82,9 +224,37 @@ func (s *server) Publish(ctx context.Context, req *pb.PublishRequest) (*pb.Publi
 		}, err
 	}
 
-	log.Printf("[RabbitMQ] Publicado: %s", body)
+	log.Printf("[RabbitMQ] Publicado: %s - %s - %s", req.Description, req.Country, req.Weather)
 	return &pb.PublishResponse{
 		Success: true,
 		Info:    "Publicado en RabbitMQ con éxito",
 	}, nil
 }
+
+func (s *server) PublishBatch(ctx context.Context, req *pb.PublishBatchRequest) (*pb.PublishBatchResponse, error) {
+	if len(req.Messages) == 0 {
+		return &pb.PublishBatchResponse{Success: true, Info: "Lote vacío"}, nil
+	}
+
+	err := s.publish(ctx, req.Messages)
+	if err != nil {
+		return &pb.PublishBatchResponse{
+			Success: false,
+			Info:    fmt.Sprintf("Error publicando: %v", err),
+		}, err
+	}
+
+	log.Printf("[RabbitMQ] Publicado lote de %d mensajes", len(req.Messages))
+	return &pb.PublishBatchResponse{
+		Success:   true,
+		Info:      "Publicado en RabbitMQ con éxito",
+		Published: int32(len(req.Messages)),
+	}, nil
+}
+
+func envInt(name string, def int) int {
+	if v, err := strconv.Atoi(os.Getenv(name)); err == nil && v > 0 {
+		return v
+	}
+	return def
+}